@@ -0,0 +1,205 @@
+#include "AttributesTable.h"
+
+using namespace std;
+
+void AttributesTable::setDef(const AttributesDef &def)
+{
+    _dictionaries.clear();
+    _stringColumns.clear();
+    for(int k=0; k<def.numStringValues(); k++)
+    {
+        _dictionaries.push_back(make_shared<StringPool>());
+        _stringColumns.push_back(vector<int>(_size, _size > 0 ? _dictionaries[k]->intern(StringView()) : 0));
+    }
+    _intColumns.assign(def.numIntValues(), vector<int>(_size, 0));
+    _floatColumns.assign(def.numFloatValues(), vector<double>(_size, 0.0));
+    _stringRestrictions.assign(def.numStringValues(), vector<StringRestrictions>());
+    _intRestrictions.assign(def.numIntValues(), vector<IntRestrictions>());
+    _floatRestrictions.assign(def.numFloatValues(), vector<FloatRestrictions>());
+}
+
+/** Adds the restriction to the column, only creating the column's restrictions if needed */
+template<typename R>
+static void addRestriction(vector<R> &restrictions, const R &r, int row)
+{
+    if(restrictions.empty())
+    {
+        if(r.exact())
+            return;
+        restrictions.resize(row);
+    }
+    restrictions.push_back(r);
+}
+
+void AttributesTable::push_back(const Attributes &a)
+{
+    for(int k=0; k<_stringColumns.size(); k++)
+    {
+        if(k < a.stringValues().size())
+        {
+            _stringColumns[k].push_back(intern(k, a.stringValues()[k]));
+            addRestriction(_stringRestrictions[k], a.stringRestrictions()[k], _size);
+        }
+        else
+            _stringColumns[k].push_back(intern(k, StringView()));
+    }
+    for(int k=0; k<_intColumns.size(); k++)
+    {
+        if(k < a.intValues().size())
+        {
+            _intColumns[k].push_back(a.intValues()[k]);
+            addRestriction(_intRestrictions[k], a.intRestrictions()[k], _size);
+        }
+        else
+            _intColumns[k].push_back(0);
+    }
+    for(int k=0; k<_floatColumns.size(); k++)
+    {
+        if(k < a.floatValues().size())
+        {
+            _floatColumns[k].push_back(a.floatValues()[k]);
+            addRestriction(_floatRestrictions[k], a.floatRestrictions()[k], _size);
+        }
+        else
+            _floatColumns[k].push_back(0.0);
+    }
+    _size++;
+    // Any restriction columns that didn't get a value get the default
+    resize(_size);
+}
+
+void AttributesTable::push_back(const AttributesTable &src, int row)
+{
+    for(int k=0; k<_stringColumns.size(); k++)
+    {
+        // IDs can be copied directly if the dictionary is the same
+        int id = src._stringColumns[k][row];
+        if(id >= 0 && !sharesDictionary(k, src))
+            id = intern(k, src.stringValue(k, row));
+        _stringColumns[k].push_back(id);
+        if(!src._stringRestrictions[k].empty())
+            addRestriction(_stringRestrictions[k], src._stringRestrictions[k][row], _size);
+    }
+    for(int k=0; k<_intColumns.size(); k++)
+    {
+        _intColumns[k].push_back(src._intColumns[k][row]);
+        if(!src._intRestrictions[k].empty())
+            addRestriction(_intRestrictions[k], src._intRestrictions[k][row], _size);
+    }
+    for(int k=0; k<_floatColumns.size(); k++)
+    {
+        _floatColumns[k].push_back(src._floatColumns[k][row]);
+        if(!src._floatRestrictions[k].empty())
+            addRestriction(_floatRestrictions[k], src._floatRestrictions[k][row], _size);
+    }
+    _size++;
+    resize(_size);
+}
+
+void AttributesTable::resize(int n)
+{
+    for(int k=0; k<_stringColumns.size(); k++)
+        _stringColumns[k].resize(n, n > _size ? intern(k, StringView()) : 0);
+    for(auto &column : _intColumns)
+        column.resize(n, 0);
+    for(auto &column : _floatColumns)
+        column.resize(n, 0.0);
+    // Restrictions are only resized if the column uses them
+    for(auto &restrictions : _stringRestrictions)
+        if(!restrictions.empty())
+            restrictions.resize(n);
+    for(auto &restrictions : _intRestrictions)
+        if(!restrictions.empty())
+            restrictions.resize(n);
+    for(auto &restrictions : _floatRestrictions)
+        if(!restrictions.empty())
+            restrictions.resize(n);
+    _size = n;
+}
+
+void AttributesTable::reserve(int n)
+{
+    for(auto &column : _stringColumns)
+        column.reserve(n);
+    for(auto &column : _intColumns)
+        column.reserve(n);
+    for(auto &column : _floatColumns)
+        column.reserve(n);
+}
+
+Attributes AttributesTable::row(int i) const
+{
+    Attributes a;
+    for(int k=0; k<_stringColumns.size(); k++)
+    {
+        if(_stringRestrictions[k].empty() || _stringRestrictions[k][i].exact())
+            a.addStringValue(stringValue(k, i));
+        else
+            a.addStringValue(_stringRestrictions[k][i]);
+    }
+    for(int k=0; k<_intColumns.size(); k++)
+    {
+        if(_intRestrictions[k].empty() || _intRestrictions[k][i].exact())
+            a.addIntValue(_intColumns[k][i]);
+        else
+            a.addIntValue(_intRestrictions[k][i]);
+    }
+    for(int k=0; k<_floatColumns.size(); k++)
+    {
+        if(_floatRestrictions[k].empty() || _floatRestrictions[k][i].exact())
+            a.addFloatValue(_floatColumns[k][i]);
+        else
+            a.addFloatValue(_floatRestrictions[k][i]);
+    }
+    return a;
+}
+
+StringView AttributesTable::stringValue(int k, int row) const
+{
+    int id = _stringColumns[k][row];
+    return id >= 0 ? _dictionaries[k]->get(id) : StringView();
+}
+
+StringPool &AttributesTable::dictionary(int k)
+{
+    // Copy on write, so nothing changes for the other tables sharing it
+    if(_dictionaries[k].use_count() > 1)
+        _dictionaries[k] = make_shared<StringPool>(*_dictionaries[k]);
+    return *_dictionaries[k];
+}
+
+int AttributesTable::intern(int k, StringView str)
+{
+    int id = _dictionaries[k]->find(str);
+    if(id < 0)
+        id = dictionary(k).intern(str);
+    return id;
+}
+
+int AttributesTable::useDictionaries(const AttributesTable &dict)
+{
+    if(dict._stringColumns.size() != _stringColumns.size())
+        throw "Can't share dictionaries between attribute tables with different definitions.";
+    int numMissing = 0;
+    for(int k=0; k<_stringColumns.size(); k++)
+    {
+        if(sharesDictionary(k, dict))
+            continue;
+        // Translate each of our string IDs once
+        const StringPool &oldDict = *_dictionaries[k];
+        vector<int> newIDs(oldDict.size());
+        for(int id=0; id<oldDict.size(); id++)
+            newIDs[id] = dict._dictionaries[k]->find(oldDict.get(id));
+        for(int row=0; row<_size; row++)
+        {
+            int &id = _stringColumns[k][row];
+            if(id < 0)
+                continue;
+            id = newIDs[id];
+            if(id < 0 && (_stringRestrictions[k].empty() || !_stringRestrictions[k][row].any()))
+                numMissing++;
+        }
+        _dictionaries[k] = dict._dictionaries[k];
+    }
+    return numMissing;
+}
@@ -0,0 +1,136 @@
+/*
+ * File:   AttributesTable.h
+ * Author: D3M430
+ *
+ * Created on March 17, 2021, 2:05 PM
+ */
+
+#ifndef ATTRIBUTESTABLE_H
+#define	ATTRIBUTESTABLE_H
+
+#include <memory>
+#include <string>
+#include <vector>
+#include "Attributes.h"
+#include "AttributesDef.h"
+#include "StringPool.h"
+
+/**
+ * Column oriented storage for the attributes of all the nodes (or edges)
+ * of a graph.  There's one array of values for each DATA attribute in the
+ * definition, and each row is a node or edge.  Columns are indexed by their
+ * position among the attributes of the same data type, just like the
+ * values in Attributes.
+ *
+ * Restrictions (such as min/max) are only used by query graphs, so a
+ * column only gets an array of restrictions once a value that isn't an
+ * exact value is added to it.
+ *
+ * String columns are dictionary encoded: each value is the ID of the string
+ * in the column's dictionary.  Copies of a table share its dictionaries
+ * until one of them adds a string that isn't in them yet, so values from
+ * tables with the same dictionary can be compared by ID.
+ */
+class AttributesTable
+{
+public:
+    AttributesTable() : _size(0) {}
+    /** Creates a column for each DATA attribute in the definition.  Existing rows get empty values. */
+    void setDef(const AttributesDef &def);
+    /** Number of rows */
+    int size() const { return _size; }
+    /** Adds a row with the given values (and restrictions).  Missing values are left empty. */
+    void push_back(const Attributes &a);
+    /** Adds a copy of a row from another table with the same definition */
+    void push_back(const AttributesTable &src, int row);
+    /** Adds or removes rows at the end, so there are n rows.  New rows get empty values. */
+    void resize(int n);
+    /** Makes room for n rows */
+    void reserve(int n);
+    /** Removes all rows, keeping the columns */
+    void clear() { resize(0); }
+    /** Copies a row into an Attributes object */
+    Attributes row(int i) const;
+
+    /**
+     * Reorders the rows.  Each column (including any restrictions) is passed
+     * to reorder(columnValues), which must rearrange the values in place.
+     */
+    template<typename Reorder>
+    void permute(Reorder reorder);
+    /**
+     * Re-encodes the string columns with the dictionaries of another table
+     * (with the same definition), so their values can be compared by ID.
+     * Strings that aren't in the other table's dictionaries get an ID of -1,
+     * and lose their value.
+     * @return  Number of exact string values (not allowing any value) that
+     * weren't in the other table's dictionaries.
+     */
+    int useDictionaries(const AttributesTable &dict);
+
+    int numStringColumns() const { return _stringColumns.size(); }
+    int numIntColumns() const { return _intColumns.size(); }
+    int numFloatColumns() const { return _floatColumns.size(); }
+    /** Dictionary IDs of the values of the k-th string attribute (-1 if the value isn't in the dictionary) */
+    const std::vector<int> &stringColumn(int k) const { return _stringColumns[k]; }
+    std::vector<int> &stringColumn(int k) { return _stringColumns[k]; }
+    /** Value of the k-th string attribute in the given row */
+    StringView stringValue(int k, int row) const;
+    /** Strings used by the k-th string attribute */
+    const StringPool &dictionary(int k) const { return *_dictionaries[k]; }
+    /** Strings used by the k-th string attribute.  Makes our own copy first, if it's shared. */
+    StringPool &dictionary(int k);
+    /** True if the k-th string attribute of both tables uses the same dictionary, so IDs can be compared */
+    bool sharesDictionary(int k, const AttributesTable &rhs) const { return _dictionaries[k] == rhs._dictionaries[k]; }
+    /** Values of the k-th int attribute */
+    const std::vector<int> &intColumn(int k) const { return _intColumns[k]; }
+    std::vector<int> &intColumn(int k) { return _intColumns[k]; }
+    /** Values of the k-th float attribute */
+    const std::vector<double> &floatColumn(int k) const { return _floatColumns[k]; }
+    std::vector<double> &floatColumn(int k) { return _floatColumns[k]; }
+    /** Restrictions of the k-th string attribute (empty if all its values are exact) */
+    const std::vector<StringRestrictions> &stringRestrictions(int k) const { return _stringRestrictions[k]; }
+    /** Restrictions of the k-th int attribute (empty if all its values are exact) */
+    const std::vector<IntRestrictions> &intRestrictions(int k) const { return _intRestrictions[k]; }
+    /** Restrictions of the k-th float attribute (empty if all its values are exact) */
+    const std::vector<FloatRestrictions> &floatRestrictions(int k) const { return _floatRestrictions[k]; }
+
+private:
+    /** Dictionary ID of the string in the k-th string column, adding it if needed */
+    int intern(int k, StringView str);
+
+    int _size;
+    std::vector<std::shared_ptr<StringPool>> _dictionaries;
+    std::vector<std::vector<int>> _stringColumns;
+    std::vector<std::vector<int>> _intColumns;
+    std::vector<std::vector<double>> _floatColumns;
+    std::vector<std::vector<StringRestrictions>> _stringRestrictions;
+    std::vector<std::vector<IntRestrictions>> _intRestrictions;
+    std::vector<std::vector<FloatRestrictions>> _floatRestrictions;
+};
+
+template<typename Reorder>
+void AttributesTable::permute(Reorder reorder)
+{
+    for(int k=0; k<_stringColumns.size(); k++)
+    {
+        reorder(_stringColumns[k]);
+        if(!_stringRestrictions[k].empty())
+            reorder(_stringRestrictions[k]);
+    }
+    for(int k=0; k<_intColumns.size(); k++)
+    {
+        reorder(_intColumns[k]);
+        if(!_intRestrictions[k].empty())
+            reorder(_intRestrictions[k]);
+    }
+    for(int k=0; k<_floatColumns.size(); k++)
+    {
+        reorder(_floatColumns[k]);
+        if(!_floatRestrictions[k].empty())
+            reorder(_floatRestrictions[k]);
+    }
+}
+
+#endif	/* ATTRIBUTESTABLE_H */
+
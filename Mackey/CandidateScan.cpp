@@ -0,0 +1,141 @@
+#include "CandidateScan.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CANDIDATESCAN_X86
+#include <immintrin.h>
+#endif
+
+const CandidateScan::FilterFunction CandidateScan::_filter = CandidateScan::pickFilter();
+
+CandidateScan::CandidateScan(const Graph &g, const EdgeMasks &masks, int h_i, bool selfLoop, int g_u, int g_v, ListType list) :
+    _sources(g.edges().sources().data()), _dests(g.edges().dests().data()), _masks(masks.masks()),
+    _bit(EdgeMasks::Mask(1) << h_i), _selfLoop(selfLoop), _g_u(g_u), _g_v(g_v)
+{
+    _checkMasks = (list != MATCHING_EDGES);
+    _checkSources = (list == MATCHING_EDGES || list == DEST_EDGES);
+    _checkDests = (list == MATCHING_EDGES || list == SOURCE_EDGES);
+}
+
+const char *CandidateScan::instructionSet()
+{
+    if(_filter == filterAVX512)
+        return "avx512";
+    if(_filter == filterAVX2)
+        return "avx2";
+    return "scalar";
+}
+
+CandidateScan::FilterFunction CandidateScan::pickFilter()
+{
+#ifdef CANDIDATESCAN_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx512f"))
+        return filterAVX512;
+    if(__builtin_cpu_supports("avx2"))
+        return filterAVX2;
+#endif
+    return filterScalar;
+}
+
+int CandidateScan::filterScalar(const CandidateScan &scan, const int *first, const int *last, int *out)
+{
+    int numOut = 0;
+    for(; first != last; ++first)
+    {
+        int g_e = *first;
+        if(scan._checkMasks && (scan._masks[g_e] & scan._bit) == 0)
+            continue;
+        int g_u = scan._checkSources ? scan._sources[g_e] : scan._g_u;
+        int g_v = scan._checkDests ? scan._dests[g_e] : scan._g_v;
+        if((g_u == g_v) != scan._selfLoop)
+            continue;
+        if((scan._g_u >= 0 && g_u != scan._g_u) || (scan._g_v >= 0 && g_v != scan._g_v))
+            continue;
+        out[numOut++] = g_e;
+    }
+    return numOut;
+}
+
+#ifdef CANDIDATESCAN_X86
+
+__attribute__((target("avx2")))
+int CandidateScan::filterAVX2(const CandidateScan &scan, const int *first, const int *last, int *out)
+{
+    const __m256i bit = _mm256_set1_epi64x(scan._bit);
+    const __m256i g_u = _mm256_set1_epi32(scan._g_u);
+    const __m256i g_v = _mm256_set1_epi32(scan._g_v);
+    const long long *masks = (const long long*)scan._masks;
+    int numOut = 0;
+    for(; last - first >= 8; first += 8)
+    {
+        // Gather the ends and masks of 8 candidates (the ones we don't
+        // already know), and make a bit for each candidate that passes each check
+        __m256i edges = _mm256_loadu_si256((const __m256i*)first);
+        __m256i sources = scan._checkSources ? _mm256_i32gather_epi32(scan._sources, edges, 4) : g_u;
+        __m256i dests = scan._checkDests ? _mm256_i32gather_epi32(scan._dests, edges, 4) : g_v;
+        int pass = 0xFF;
+        if(scan._checkMasks)
+        {
+            __m256i masks0 = _mm256_i32gather_epi64(masks, _mm256_castsi256_si128(edges), 8);
+            __m256i masks1 = _mm256_i32gather_epi64(masks, _mm256_extracti128_si256(edges, 1), 8);
+            pass = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_and_si256(masks0, bit), bit))) |
+                   _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(_mm256_and_si256(masks1, bit), bit))) << 4;
+        }
+        int loops = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(sources, dests)));
+        pass &= scan._selfLoop ? loops : ~loops;
+        if(scan._checkSources && scan._g_u >= 0)
+            pass &= _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(sources, g_u)));
+        if(scan._checkDests && scan._g_v >= 0)
+            pass &= _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(dests, g_v)));
+        for(; pass != 0; pass &= pass - 1)
+            out[numOut++] = first[__builtin_ctz(pass)];
+    }
+    return numOut + filterScalar(scan, first, last, out + numOut);
+}
+
+__attribute__((target("avx512f")))
+int CandidateScan::filterAVX512(const CandidateScan &scan, const int *first, const int *last, int *out)
+{
+    const __m512i bit = _mm512_set1_epi64(scan._bit);
+    const __m512i g_u = _mm512_set1_epi32(scan._g_u);
+    const __m512i g_v = _mm512_set1_epi32(scan._g_v);
+    int numOut = 0;
+    for(; last - first >= 16; first += 16)
+    {
+        // Gather the ends and masks of 16 candidates (the ones we don't
+        // already know), and keep the ones that pass every check
+        __m512i edges = _mm512_loadu_si512(first);
+        __m512i sources = scan._checkSources ? _mm512_i32gather_epi32(edges, scan._sources, 4) : g_u;
+        __m512i dests = scan._checkDests ? _mm512_i32gather_epi32(edges, scan._dests, 4) : g_v;
+        __mmask16 pass = 0xFFFF;
+        if(scan._checkMasks)
+        {
+            __m512i masks0 = _mm512_i32gather_epi64(_mm512_castsi512_si256(edges), scan._masks, 8);
+            __m512i masks1 = _mm512_i32gather_epi64(_mm512_extracti64x4_epi64(edges, 1), scan._masks, 8);
+            pass = _mm512_test_epi64_mask(masks0, bit) | (__mmask16)(_mm512_test_epi64_mask(masks1, bit) << 8);
+        }
+        __mmask16 loops = _mm512_cmpeq_epi32_mask(sources, dests);
+        pass &= scan._selfLoop ? loops : (__mmask16)~loops;
+        if(scan._checkSources && scan._g_u >= 0)
+            pass &= _mm512_cmpeq_epi32_mask(sources, g_u);
+        if(scan._checkDests && scan._g_v >= 0)
+            pass &= _mm512_cmpeq_epi32_mask(dests, g_v);
+        _mm512_mask_compressstoreu_epi32(out + numOut, pass, edges);
+        numOut += __builtin_popcount(pass);
+    }
+    return numOut + filterScalar(scan, first, last, out + numOut);
+}
+
+#else
+
+int CandidateScan::filterAVX2(const CandidateScan &scan, const int *first, const int *last, int *out)
+{
+    return filterScalar(scan, first, last, out);
+}
+
+int CandidateScan::filterAVX512(const CandidateScan &scan, const int *first, const int *last, int *out)
+{
+    return filterScalar(scan, first, last, out);
+}
+
+#endif
@@ -0,0 +1,94 @@
+/*
+ * File:   CandidateScan.h
+ * Author: D3M430
+ *
+ * Created on April 9, 2021, 11:05 AM
+ */
+
+#ifndef CANDIDATESCAN_H
+#define	CANDIDATESCAN_H
+
+#include "EdgeMasks.h"
+#include "Graph.h"
+
+/**
+ * Filters lists of candidate edges for a query edge down to the ones that
+ * pass the checks that are plain compares against values fixed for the
+ * query edge: its bit in the edge masks, whether it's a self loop, and the
+ * nodes its ends are already matched to (if any).  The rest of the checks
+ * (whether new ends are free, and in their domains) are left to the
+ * search.  The times are left out too, since the search only scans the
+ * edges in its time range.
+ *
+ * Only the columns the kind of list doesn't settle are looked at.  On x86
+ * CPUs with AVX-512 or AVX2 (picked when the program runs), it tests 16
+ * or 8 candidates at once, gathering those columns.  Otherwise, or when
+ * there are only a few candidates (which is most of the time deeper in a
+ * search, where the gathers cost more than they save), it tests them one
+ * at a time.
+ */
+class CandidateScan
+{
+public:
+    /** Most candidates to filter at once, which is how much room the output needs */
+    static const int BLOCK_SIZE = 64;
+    /** Fewest candidates worth gathering; shorter lists are tested one at a time */
+    static const int MIN_VECTOR_SIZE = 32;
+
+    /** Kinds of lists of candidates, which tell us what's already known about them */
+    enum ListType
+    {
+        // Edges that meet the criteria (from EdgeMasks::edges)
+        MATCHING_EDGES,
+        // Out edges of the node the source is matched to
+        SOURCE_EDGES,
+        // In edges of the node the dest is matched to
+        DEST_EDGES,
+        // Edges between the nodes both ends are matched to
+        PAIR_EDGES
+    };
+
+    /**
+     * Sets up the scan for candidates of a query edge.
+     * @param g  The graph being searched.
+     * @param masks  Query edges each edge of g meets the criteria of.
+     * @param h_i  Index of the query edge.
+     * @param selfLoop  True if the query edge is a self loop.
+     * @param g_u  Node the query edge's source is matched to (or -1).
+     * @param g_v  Node the query edge's dest is matched to (or -1).
+     * @param list  Kind of list the candidates come from.
+     */
+    CandidateScan(const Graph &g, const EdgeMasks &masks, int h_i, bool selfLoop, int g_u, int g_v, ListType list);
+
+    /**
+     * Copies the candidate edges that pass to out, in order.
+     * @param first  First candidate edge index.
+     * @param last  End of the candidates (at most BLOCK_SIZE after first).
+     * @param out  Where to put the edges that pass.
+     * @return  Number of edges that pass.
+     */
+    int filter(const int *first, const int *last, int *out) const { return (last - first >= MIN_VECTOR_SIZE ? _filter : filterScalar)(*this, first, last, out); }
+
+    /** Instructions the scan uses on this CPU ("avx512", "avx2" or "scalar") */
+    static const char *instructionSet();
+
+private:
+    typedef int (*FilterFunction)(const CandidateScan &scan, const int *first, const int *last, int *out);
+
+    static int filterScalar(const CandidateScan &scan, const int *first, const int *last, int *out);
+    static int filterAVX2(const CandidateScan &scan, const int *first, const int *last, int *out);
+    static int filterAVX512(const CandidateScan &scan, const int *first, const int *last, int *out);
+    /** Picks the filter for this CPU */
+    static FilterFunction pickFilter();
+
+    static const FilterFunction _filter;
+    const int *_sources, *_dests;
+    const EdgeMasks::Mask *_masks;
+    EdgeMasks::Mask _bit;
+    bool _selfLoop;
+    int _g_u, _g_v;
+    // Which columns have to be looked at, since the list doesn't already tell us
+    bool _checkMasks, _checkSources, _checkDests;
+};
+
+#endif	/* CANDIDATESCAN_H */
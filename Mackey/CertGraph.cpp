@@ -14,7 +14,7 @@ string CertGraph::getUserRole(const string &user, const Roles &roles)
     return userRole;
 }
 
-void CertGraph::addLabeledNode(int v, std::string label)
+void CertGraph::addLabeledNode(int v, StringView label)
 {
     //throw "CertGraph::addNode(int,string) not usable";
         
@@ -37,7 +37,7 @@ void CertGraph::addEdge(int u, int v, time_t dateTime)
         
     // Call base class
     LabeledWeightedGraph::addEdge(u, v, dateTime);    
-    this->_timeEdgeTypeMap[dateTime].push_back("");
+    this->_newEdgeTypes.push_back("");
 }
     
 void CertGraph::addWeightedEdge(int u, int v, time_t dateTime, double weight)
@@ -46,7 +46,7 @@ void CertGraph::addWeightedEdge(int u, int v, time_t dateTime, double weight)
         
     // Call base class
     LabeledWeightedGraph::addWeightedEdge(u, v, dateTime, weight);
-    this->_timeEdgeTypeMap[dateTime].push_back("");
+    this->_newEdgeTypes.push_back("");
 }
     
 void CertGraph::copyEdge(int edgeIndex, const Graph &g)
@@ -255,7 +255,7 @@ void CertGraph::addEdge(const std::string &source, const std::string &dest, time
 void CertGraph::addEdge(int u, int v, time_t dateTime, const std::string &type)
 {    
     LabeledWeightedGraph::addEdge(u, v, dateTime);
-    _timeEdgeTypeMap[dateTime].push_back(type);
+    _newEdgeTypes.push_back(type);
     
     // Get degrees for this edge type
     vector<int> &outDegs = _typeOutDegs[type];
@@ -436,18 +436,6 @@ void CertGraph::updateOrderedEdges() const
     // Make sure base class is updated first
     LabeledWeightedGraph::updateOrderedEdges();
     
-    // Clear old edge weights
-    _edgeTypes.clear();
-    
-    // Build edge list in chronological order
-    for(auto &pair : _timeEdgeTypeMap)
-    {
-        time_t dateTime = pair.first;
-        const vector<string> &types = _timeEdgeTypeMap.find(dateTime)->second;
-        for(const string &type : types)
-        {
-            //cout << "Adding edge type: " << type << endl;
-            _edgeTypes.push_back(type);
-        }
-    }
+    // Put edge types in chronological order
+    this->reorderEdgeValues(_edgeTypes, _newEdgeTypes);
 }
@@ -43,7 +43,7 @@ public:
    
     CertGraph(int windowDuration) : LabeledWeightedGraph(windowDuration) { }
     /** Overriding from base class. Adds a node with the appropriate label. (Nodes will have blank string otherwise.) */
-    void addLabeledNode(int v, std::string label) override;
+    void addLabeledNode(int v, StringView label) override;
     /** Adds a node with all the CERT metadata we are using */
     void addTypedNode(const std::string &name, const std::string &type); //, double weight);
     /** Overriding from base class. Adds edge with 0.0 weight */
@@ -142,8 +142,8 @@ private:
     std::unordered_map<int,std::vector<DegRestriction>> _degRestricts;
     std::unordered_set<int> _needsNameMatch;
     std::unordered_map<int,std::regex> _regexMatch;
-    // Ordered map, by date/time
-    std::map<time_t,std::vector<std::string>> _timeEdgeTypeMap;
+    // Edge types for the edges added since the ordered edges were last updated
+    mutable std::vector<std::string> _newEdgeTypes;
     // Ordered list of edges for the graph
     //mutable std::vector<Edge> _edges;
     mutable std::vector<std::string> _edgeTypes;
@@ -8,6 +8,12 @@ CmdArgs::CmdArgs(int argc, char **argv)
 {
     _success = true; // Unless proven otherwise
     _unordered = false; // By default, take chronological ordering into account
+    _numThreads = 1; // By default, search on a single thread
+    _limit = INT_MAX; // By default, find every matching subgraph
+    _maxSamples = 0; // By default, count exactly (rather than estimate)
+    _targetError = 0;
+    _census = false; // By default, search for the given queries
+    _algorithm = GraphSearch::TIME_ORDER; // By default, match the query edges in time order
 
     if(argc <= 1)
     {
@@ -35,6 +41,33 @@ CmdArgs::CmdArgs(int argc, char **argv)
 		_success = false;		
 	    }
 	}
+	else if(arg == "-snapshot")
+	{
+	    i++;
+	    if(i == argc)
+	    {
+		cout << "Missing snapshot file after -snapshot argument." << endl;
+		_success = false;
+		continue;
+	    }
+	    _snapshotFname = argv[i];
+	    if(FileIO::fileExists(_snapshotFname)==false)
+	    {
+		cout << "Snapshot file \"" << _snapshotFname << "\" does not exist, or cannot be opened." << endl;
+		_success = false;		
+	    }
+	}
+	else if(arg == "-save_snapshot")
+	{
+	    i++;
+	    if(i == argc)
+	    {
+		cout << "Missing snapshot file after -save_snapshot argument." << endl;
+		_success = false;
+		continue;
+	    }
+	    _saveSnapshotFname = argv[i];
+	}
 	else if(arg == "-q")
 	{
 	    i++;
@@ -94,6 +127,94 @@ CmdArgs::CmdArgs(int argc, char **argv)
 		_success = false;
 	    }
 	}
+	else if(arg == "-threads")
+	{
+	    i++;
+	    if(i == argc)
+	    {
+		cout << "Missing number of threads after -threads argument." << endl;
+		_success = false;
+		continue;
+	    }
+	    _numThreads = atoi(argv[i]);
+	    if(_numThreads < 0)
+	    {
+		cout << "Number of threads must be an integer >= 0." << endl;
+		_success = false;
+	    }
+	}
+	else if(arg == "-limit")
+	{
+	    i++;
+	    if(i == argc)
+	    {
+		cout << "Missing number of subgraphs after -limit argument." << endl;
+		_success = false;
+		continue;
+	    }
+	    _limit = atoi(argv[i]);
+	    if(_limit < 1)
+	    {
+		cout << "Limit must be an integer >= 1." << endl;
+		_success = false;
+	    }
+	}
+	else if(arg == "-samples")
+	{
+	    i++;
+	    if(i == argc)
+	    {
+		cout << "Missing number of samples after -samples argument." << endl;
+		_success = false;
+		continue;
+	    }
+	    _maxSamples = atol(argv[i]);
+	    if(_maxSamples < 1)
+	    {
+		cout << "Number of samples must be an integer >= 1." << endl;
+		_success = false;
+	    }
+	}
+	else if(arg == "-error")
+	{
+	    i++;
+	    if(i == argc)
+	    {
+		cout << "Missing target error after -error argument." << endl;
+		_success = false;
+		continue;
+	    }
+	    _targetError = atof(argv[i]);
+	    if(_targetError <= 0 || _targetError >= 1)
+	    {
+		cout << "Target error must be a fraction between 0 and 1 (such as 0.01)." << endl;
+		_success = false;
+	    }
+	}
+	else if(arg == "-census")
+	{
+	    _census = true;
+	}
+	else if(arg == "-algorithm")
+	{
+	    i++;
+	    if(i == argc)
+	    {
+		cout << "Missing algorithm name after -algorithm argument." << endl;
+		_success = false;
+		continue;
+	    }
+	    string name = argv[i];
+	    if(name == "timeorder")
+		_algorithm = GraphSearch::TIME_ORDER;
+	    else if(name == "temporalri")
+		_algorithm = GraphSearch::TEMPORAL_RI;
+	    else
+	    {
+		cout << "Unknown algorithm \"" << name << "\".  Use timeorder or temporalri." << endl;
+		_success = false;
+	    }
+	}
 	else
 	{
 	    cout << "Unknown command line argument: " << arg << endl;
@@ -105,16 +226,37 @@ CmdArgs::CmdArgs(int argc, char **argv)
     if(_deltaValues.empty())
         _deltaValues.push_back(60*60*24);
 
-    if(_graphFname.empty())
+    if(_graphFname.empty() && _snapshotFname.empty())
+    {
+	cout << "Missing graph file. Specify with the -g or -snapshot argument." << endl;
+	_success = false;
+    }
+    if(!_graphFname.empty() && !_snapshotFname.empty())
     {
-	cout << "Missing graph file. Specify with the -g argument." << endl;
+	cout << "Only one of the -g and -snapshot arguments can be used." << endl;
 	_success = false;
     }
-    if(_queryFnames.empty())
+    // Queries aren't needed if we are just creating a snapshot, or counting motifs
+    if(_queryFnames.empty() && _saveSnapshotFname.empty() && !_census)
     {
 	cout << "Missing query file. Specify with the -q argument." << endl;
 	_success = false;
     }
+    if(_census && (!_queryFnames.empty() || estimate() || _limit < INT_MAX))
+    {
+        cout << "The -census argument can't be used with queries, -limit, -samples or -error." << endl;
+        _success = false;
+    }
+    if(estimate() && _limit < INT_MAX)
+    {
+        cout << "The -limit argument can't be used with -samples or -error." << endl;
+        _success = false;
+    }
+    if(estimate() && _algorithm != GraphSearch::TIME_ORDER)
+    {
+        cout << "Counts can only be estimated with the timeorder algorithm." << endl;
+        _success = false;
+    }
     if(_deltaValues.size() > 1 && _outFname.empty() == false)
     {
         cout << "If using multiple delta values, you need to use the computer generated output filenames" << endl;
@@ -149,6 +291,9 @@ void CmdArgs::dispHelp() const
     cout << "Graph input arguments:" << endl;
     cout << "  -g [filename]" << endl;
     cout << "       Specifies the name of the GDF graph we want to search against." << endl;
+    cout << "  -snapshot [filename]" << endl;
+    cout << "       Loads the graph we want to search against from a binary snapshot" << endl;
+    cout << "       (created with -save_snapshot), instead of a GDF file." << endl;
     cout << endl;
     cout << "Query input arguments:" << endl;
     cout << "  -q [filename]" << endl;
@@ -159,11 +304,37 @@ void CmdArgs::dispHelp() const
     cout << "       Filename of the GDF file to save the combined results to." << endl;
     cout << "       If no name is specified, then a default filename is used, based" << endl;
     cout << "       on the input filenames and the delta value used." << endl;
+    cout << "  -save_snapshot [filename]" << endl;
+    cout << "       Saves the graph (and its indexes) as a binary snapshot, which loads" << endl;
+    cout << "       much faster than the GDF file.  No query is needed with this option." << endl;
     cout << endl;
     cout << "Other arguments:" << endl;
     cout << "  -delta [t]" << endl;
     cout << "       Specifies max duration (in seconds) between matched temporal edges." << endl;
     cout << "       (Default is 24 hours)." << endl;
+    cout << "  -threads [n]" << endl;
+    cout << "       Number of threads to search with.  Use 0 for one thread per core." << endl;
+    cout << "       (Default is 1)." << endl;
+    cout << "  -limit [n]" << endl;
+    cout << "       Stops searching once n matching subgraphs are found." << endl;
+    cout << "       (Default is no limit)." << endl;
+    cout << "  -algorithm [name]" << endl;
+    cout << "       Algorithm to search with.  timeorder matches the query edges in time" << endl;
+    cout << "       order.  temporalri uses the TemporalRI ordering, which matches the" << endl;
+    cout << "       best connected query nodes first, and needs a connected query graph." << endl;
+    cout << "       (Default is timeorder)." << endl;
+    cout << "  -samples [n]" << endl;
+    cout << "       Estimates the counts from the matches starting at a random sample" << endl;
+    cout << "       of at most n edges, rather than searching the whole graph." << endl;
+    cout << "       (Default is to count exactly)." << endl;
+    cout << "  -error [e]" << endl;
+    cout << "       Estimates the counts by sampling (as with -samples), until the 95%" << endl;
+    cout << "       confidence margin is within the fraction e of the count (such as" << endl;
+    cout << "       0.01 for 1%).  Can be used with -samples to limit the sample size." << endl;
+    cout << "       (Default is to count exactly)." << endl;
+    cout << "  -census" << endl;
+    cout << "       Instead of searching for queries, counts every motif of 3 temporal" << endl;
+    cout << "       edges on 2 or 3 nodes, each with increasing times within delta." << endl;
     cout << "NOTE:" << endl;
     cout << "   As a shortcut, instead of entering duration times in seconds, you can use" << endl;
     cout << "   the following abbreviations for different time scales:" << endl;
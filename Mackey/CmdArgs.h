@@ -1,6 +1,7 @@
 #ifndef CMDARGS_H
 #define CMDARGS_H
 
+#include "GraphSearch.h"
 #include <string>
 #include <vector>
 #include <time.h>
@@ -15,12 +16,28 @@ public:
     //const std::string &queryFname() const { return _queryFname; }    
     //time_t delta() const { return _delta; }
     const std::string &graphFname() const { return _graphFname; }
+    const std::string &snapshotFname() const { return _snapshotFname; }
+    const std::string &saveSnapshotFname() const { return _saveSnapshotFname; }
     const std::vector<std::string> &queryFnames() const { return _queryFnames; }
     const std::string &outFname() const { return _outFname; }
     //const std::vector<std::string> &outFnames() const { return _outFnames; }
     const std::vector<time_t> &deltaValues() const { return _deltaValues; }    
     bool success() const { return _success; }
     bool unordered() const { return _unordered; }
+    /** Number of threads to search with (0 means one per core) */
+    int numThreads() const { return _numThreads; }
+    /** Max number of matching subgraphs to find for each query and delta value */
+    int limit() const { return _limit; }
+    /** Algorithm to search for ordered subgraphs with */
+    GraphSearch::Algorithm algorithm() const { return _algorithm; }
+    /** True if the counts should be estimated by sampling, rather than searched for exactly */
+    bool estimate() const { return _maxSamples > 0 || _targetError > 0; }
+    /** Max number of starting edges to sample when estimating (0 means no limit) */
+    long maxSamples() const { return _maxSamples; }
+    /** Margin (as a fraction of the count) to stop sampling at when estimating (0 means none) */
+    double targetError() const { return _targetError; }
+    /** True if every 3 edge motif should be counted, instead of searching for queries */
+    bool census() const { return _census; }
     void dispHelp() const;
      /** Parses the time in the string as seconds. Makes putting in long durations
      * less painful on the command line.
@@ -41,10 +58,16 @@ public:
     std::string createOutFname(const std::string &gFname, const std::string &hFname, time_t delta);
 private:
     std::string _graphFname, _outFname; // _queryFname
+    std::string _snapshotFname, _saveSnapshotFname;
     std::vector<std::string> _queryFnames; // _outFnames;
     std::vector<time_t> _deltaValues;
     time_t _delta;
-    bool _success, _unordered;
+    int _numThreads;
+    int _limit;
+    long _maxSamples;
+    double _targetError;
+    GraphSearch::Algorithm _algorithm;
+    bool _success, _unordered, _census;
 };
 
 #endif
@@ -0,0 +1,121 @@
+/*
+ * File:   Column.h
+ * Author: D3M430
+ *
+ * Created on March 9, 2021, 1:40 PM
+ */
+
+#ifndef COLUMN_H
+#define	COLUMN_H
+
+#include <stddef.h>
+#include <memory>
+#include <utility>
+#include <vector>
+
+/**
+ * Flat array of values used for the graph's edge columns and indexes.
+ * It either owns its values, or borrows them from memory owned by
+ * something else (such as a memory mapped graph snapshot).  A borrowed
+ * column is copied into memory it owns the first time it's modified.
+ */
+template<typename T>
+class Column
+{
+public:
+    Column() : _data(nullptr), _size(0) {}
+    Column(const Column &rhs) : _data(nullptr), _size(0) { *this = rhs; }
+    Column(Column &&rhs) : _data(rhs._data), _size(rhs._size), _owned(std::move(rhs._owned))
+    {
+        rhs._data = nullptr;
+        rhs._size = 0;
+    }
+    Column &operator=(const Column &rhs)
+    {
+        if(this == &rhs)
+            return *this;
+        if(rhs._owned)
+        {
+            _owned.reset(new std::vector<T>(*rhs._owned));
+            update();
+        }
+        else
+            borrow(rhs._data, rhs._size);
+        return *this;
+    }
+    Column &operator=(Column &&rhs)
+    {
+        _owned = std::move(rhs._owned);
+        _data = rhs._data;
+        _size = rhs._size;
+        rhs._data = nullptr;
+        rhs._size = 0;
+        return *this;
+    }
+    /** Takes ownership of the given values */
+    Column &operator=(std::vector<T> &&values)
+    {
+        _owned.reset(new std::vector<T>(std::move(values)));
+        update();
+        return *this;
+    }
+    /** Uses the given values without copying them.  They must outlive this column. */
+    void borrow(const T *data, size_t size)
+    {
+        _owned.reset();
+        _data = data;
+        _size = size;
+    }
+    /** True if the values are borrowed from somewhere else */
+    bool borrowed() const { return !_owned && _data != nullptr; }
+    void push_back(const T &value)
+    {
+        own();
+        _owned->push_back(value);
+        update();
+    }
+    void reserve(size_t n)
+    {
+        own();
+        _owned->reserve(n);
+        update();
+    }
+    void clear()
+    {
+        if(_owned)
+            _owned->clear();
+        else
+            _data = nullptr;
+        _size = 0;
+    }
+    const T &operator[](size_t i) const { return _data[i]; }
+    const T *data() const { return _data; }
+    const T *begin() const { return _data; }
+    const T *end() const { return _data + _size; }
+    const T &front() const { return _data[0]; }
+    const T &back() const { return _data[_size-1]; }
+    size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+private:
+    /** Makes sure we own our values, so they can be modified */
+    void own()
+    {
+        if(!_owned)
+        {
+            _owned.reset(new std::vector<T>(_data, _data + _size));
+            update();
+        }
+    }
+    void update()
+    {
+        _data = _owned->data();
+        _size = _owned->size();
+    }
+
+    const T *_data;
+    size_t _size;
+    std::unique_ptr<std::vector<T>> _owned;
+};
+
+#endif	/* COLUMN_H */
+
@@ -0,0 +1,47 @@
+#include "CountEstimate.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+using namespace std;
+
+void CountEstimate::add(long count)
+{
+    _numSamples++;
+    _sum += count;
+    _sumSquares += (double)count * count;
+}
+
+double CountEstimate::count() const
+{
+    if(_numSamples == 0)
+        return 0;
+    return _numRoots * (_sum / _numSamples);
+}
+
+double CountEstimate::margin() const
+{
+    if(exact())
+        return 0;
+    if(_numSamples < 2)
+        return numeric_limits<double>::infinity();
+
+    // Standard error of the total, for sampling without replacement
+    const double Z_95 = 1.96;
+    double n = _numSamples, N = _numRoots;
+    // With no matches sampled, the variance says nothing, so use the rule
+    // of three (a 95% bound on the mean of 3/n)
+    if(_sum == 0)
+        return N * 3/n * (1 - n/N);
+    double mean = _sum / n;
+    double variance = max(0.0, (_sumSquares - n*mean*mean) / (n - 1));
+    return Z_95 * N * sqrt(variance / n * (1 - n/N));
+}
+
+double CountEstimate::relativeError() const
+{
+    double m = margin();
+    if(m == 0)
+        return 0;
+    return m / count();
+}
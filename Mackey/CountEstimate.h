@@ -0,0 +1,47 @@
+/*
+ * File:   CountEstimate.h
+ * Author: D3M430
+ *
+ * Created on April 14, 2021, 10:15 AM
+ */
+
+#ifndef COUNTESTIMATE_H
+#define	COUNTESTIMATE_H
+
+/**
+ * Estimate of the number of matches of a query, from the exact number of
+ * matches that start at each of a random sample of the edges matches can
+ * start with (the roots).  Every match starts at exactly one root, so with
+ * the roots sampled without replacement, the number of roots times the mean
+ * count per sample is unbiased.  The margin comes from the sample variance
+ * (with the finite population correction), so it shrinks to zero once
+ * every root has been sampled.
+ */
+class CountEstimate
+{
+public:
+    /** Creates an estimate with no samples, out of the given number of roots */
+    CountEstimate(long numRoots = 0) : _numRoots(numRoots), _numSamples(0), _sum(0), _sumSquares(0) {}
+    /** Adds the number of matches that start at a sampled root */
+    void add(long count);
+    /** Number of roots the samples were taken from */
+    long numRoots() const { return _numRoots; }
+    /** Number of roots sampled so far */
+    long numSamples() const { return _numSamples; }
+    /** True if every root has been sampled, so the count is exact */
+    bool exact() const { return _numSamples == _numRoots; }
+    /** Estimated number of matches */
+    double count() const;
+    /** Half the width of the 95% confidence interval around the count
+     * (infinite if there aren't enough samples to tell) */
+    double margin() const;
+    /** Margin as a fraction of the count (0 if both are 0, and infinite if
+     * only the count is) */
+    double relativeError() const;
+
+private:
+    long _numRoots, _numSamples;
+    double _sum, _sumSquares;
+};
+
+#endif	/* COUNTESTIMATE_H */
@@ -5,19 +5,23 @@ using namespace std;
 
 void DataGraph::addNode(int v)
 {
-    string name = to_string(v);
-    if(_nodeNames.size() <= v)
+    checkNotFrozen();
+    if(_nodeNameIds.size() <= v)
     {
-	_nodeNames.resize(v+1);
+	_nodeNameIds.resize(v+1,-1);
 	_nodeAttributes.resize(v+1);
     }
-    _nodeNames[v] = to_string(v);
-    _nodeNameMap[name] = v;
+    int id = _nodeNames.intern(to_string(v));
+    _nodeNameIds[v] = id;
+    if(_nameNodes.size() <= id)
+        _nameNodes.resize(id+1);
+    _nameNodes[id] = v;
     Graph::addNode(v);
 }
 
-void DataGraph::addNode(const std::string &name, const Attributes &a)
+void DataGraph::addNode(StringView name, const Attributes &a)
 {
+    checkNotFrozen();
     if(_nodeAttributesDef.isSizeMatch(a) == false)
     {
         cerr << "Node added has:" << endl;
@@ -31,9 +35,12 @@ void DataGraph::addNode(const std::string &name, const Attributes &a)
 	throw "Node attributes don't match the attributes set in the definition.";
     }
 
-    int u = _nodeNameMap.size();
-    _nodeNames.push_back(name);
-    _nodeNameMap[name] = u;
+    int u = _nodeNames.size();
+    int id = _nodeNames.intern(name);
+    _nodeNameIds.push_back(id);
+    if(_nameNodes.size() <= id)
+        _nameNodes.resize(id+1);
+    _nameNodes[id] = u;
     Graph::addNode(u);
     _nodeAttributes.push_back(a);
 }
@@ -47,13 +54,12 @@ void DataGraph::addEdge(int u, int v)
 void DataGraph::addEdge(int u, int v, time_t dateTime)
 {
     Graph::addEdge(u,v,dateTime);
-    Attributes a;
-    _edgeAttributes.push_back(a);
-    _timeEdgeAttributesMap[dateTime].push_back(a);
+    _edgeAttributes.resize(_edgeAttributes.size()+1);
 }
 
-void DataGraph::addEdge(const std::string &source, const std::string &dest, time_t dateTime, const Attributes &a)
+void DataGraph::addEdge(StringView source, StringView dest, time_t dateTime, const Attributes &a)
 {
+    checkNotFrozen();
     if(_edgeAttributesDef.isSizeMatch(a) == false)
     {
         cerr << "Edge added has:" << endl;
@@ -67,11 +73,13 @@ void DataGraph::addEdge(const std::string &source, const std::string &dest, time
 	throw "Edge attributes don't match the attributes set in the definition.";
     }
 
-    int u = _nodeNameMap[source];
-    int v = _nodeNameMap[dest];
+    // Unknown names are treated as node 0
+    int sourceID = _nodeNames.find(source);
+    int destID = _nodeNames.find(dest);
+    int u = sourceID >= 0 ? _nameNodes[sourceID] : 0;
+    int v = destID >= 0 ? _nameNodes[destID] : 0;
     Graph::addEdge(u,v,dateTime);
     _edgeAttributes.push_back(a);
-    _timeEdgeAttributesMap[dateTime].push_back(a);
 }
 
 void DataGraph::copyEdge(int edgeIndex, const Graph &g)
@@ -79,45 +87,62 @@ void DataGraph::copyEdge(int edgeIndex, const Graph &g)
     const DataGraph &dg = (const DataGraph&)g;
     int n = g.nodes().size();
     // Make sure we actually have all the node values, etc, first
-    if(n > _nodeNames.size())
+    checkNotFrozen();
+    if(n > _nodeNameIds.size())
     {
 	_nodeNames = dg._nodeNames;
-	_nodeNameMap = dg._nodeNameMap;
+	_nodeNameIds = dg._nodeNameIds;
+	_nameNodes = dg._nameNodes;
 	_nodeAttributes = dg._nodeAttributes;
     }
 
+    // Share the string dictionaries, so the attributes can be copied as IDs
+    const AttributesTable &edgeAttributes = dg.edgeAttributes();
+    if(_edgeAttributes.size() == 0)
+        _edgeAttributes.useDictionaries(edgeAttributes);
+
     const Edge &edge = dg.edges()[edgeIndex];
-    const Attributes &a = dg.edgeAttributes()[edgeIndex];
 
     /*int e = this->numEdges();
     Graph::copyEdge(edgeIndex, dg);
     _edgeAttributes.push_back(a);
     _timeEdgeAttributesMap[edge.time()].push_back(a);*/
     
-    const string &node1 = _nodeNames[edge.source()];
-    const string &node2 = _nodeNames[edge.dest()];
-    this->addEdge(node1, node2, edge.time(), a);
+    Graph::addEdge(edge.source(), edge.dest(), edge.time());
+    _edgeAttributes.push_back(edgeAttributes, edgeIndex);
 }
 
 void DataGraph::setNodeAttributesDef(const AttributesDef &def)
 {
+    checkNotFrozen();
     _nodeAttributesDef = def;
+    _nodeAttributes.setDef(def);
 }
 
 void DataGraph::setEdgeAttributesDef(const AttributesDef &def)
 {
+    checkNotFrozen();
     _edgeAttributesDef = def;
+    _edgeAttributes.setDef(def);
 }
 
 const AttributesDef &DataGraph::nodeAttributesDef() const { return _nodeAttributesDef; }
 
 const AttributesDef &DataGraph::edgeAttributesDef() const { return _edgeAttributesDef; }
 
+bool DataGraph::useDictionaries(const DataGraph &g)
+{
+    checkNotFrozen();
+    int numMissing = _nodeAttributes.useDictionaries(g.nodeAttributes());
+    numMissing += _edgeAttributes.useDictionaries(g.edgeAttributes());
+    return numMissing == 0;
+}
+
 DataGraph DataGraph::createSubGraph(const std::vector<GraphMatch> &matches) const
 {
     DataGraph g;
-    g._nodeAttributesDef = this->_nodeAttributesDef;
-    g._edgeAttributesDef = this->_edgeAttributesDef;
+    g.setNodeAttributesDef(this->_nodeAttributesDef);
+    g.setEdgeAttributesDef(this->_edgeAttributesDef);
         
     // Determine which nodes we are using, and create edges between them
     unordered_map<int,int> edgeMap;
@@ -141,19 +166,17 @@ DataGraph DataGraph::createSubGraph(const std::vector<GraphMatch> &matches) cons
                 {
                     int u2 = nodeMap.size();
                     nodeMap[u] = u2;            
-                    g.addNode(this->getName(u),this->nodeAttributes()[u]);
+                    g.addNode(this->getName(u),this->nodeAttributes().row(u));
 		    //g.setNodeAttributes(u2,this->nodeAttributes()[u]);
                 }
                 if(nodeMap.find(v) == nodeMap.end())
                 {
                     int v2 = nodeMap.size();
                     nodeMap[v] = v2;
-                    g.addNode(this->getName(v),this->nodeAttributes()[v]);
+                    g.addNode(this->getName(v),this->nodeAttributes().row(v));
 		    //g.setNodeAttributes(v2,this->nodeAttributes()[v]);
                 }
-		const string &name1 = g.getName(nodeMap[u]);
-		const string &name2 = g.getName(nodeMap[v]);
-                g.addEdge(name1, name2, edge.time(), this->edgeAttributes()[e]);		
+                g.addEdge(g.getName(nodeMap[u]), g.getName(nodeMap[v]), edge.time(), this->edgeAttributes().row(e));		
 		//g.setEdgeAttributes(e2,this->edgeAttributes()[e]);
             }
         }
@@ -162,31 +185,35 @@ DataGraph DataGraph::createSubGraph(const std::vector<GraphMatch> &matches) cons
     return g;
 }
 
-const string &DataGraph::getName(int v) const
+StringView DataGraph::getName(int v) const
 {
-    return _nodeNames[v];
+    int id = _nodeNameIds[v];
+    if(id < 0)
+        return StringView();
+    return _nodeNames.get(id);
 }
 
-const std::vector<Attributes> &DataGraph::nodeAttributes() const
+const AttributesTable &DataGraph::nodeAttributes() const
 {
     return _nodeAttributes;
 }
 
-const std::vector<Attributes> &DataGraph::edgeAttributes() const
+const AttributesTable &DataGraph::edgeAttributes() const
 {
+    if(!_edgesReady)
+        this->updateOrderedEdges();
     return _edgeAttributes;
 }
 
 void DataGraph::dispNode(int u) const
 {
-    cout << u << "(" << _nodeNames[u];
-    const auto &values = _nodeAttributes[u].stringValues();
-    for(const string &val : values)
-	cout << "," << val;
-    for(int val : _nodeAttributes[u].intValues())
-        cout << "," << val;
-    for(double val : _nodeAttributes[u].floatValues())
-        cout << "," << val;
+    cout << u << "(" << getName(u);
+    for(int k=0; k<_nodeAttributes.numStringColumns(); k++)
+	cout << "," << _nodeAttributes.stringValue(k, u);
+    for(int k=0; k<_nodeAttributes.numIntColumns(); k++)
+        cout << "," << _nodeAttributes.intColumn(k)[u];
+    for(int k=0; k<_nodeAttributes.numFloatColumns(); k++)
+        cout << "," << _nodeAttributes.floatColumn(k)[u];
     cout << ")" << flush;
 }
 
@@ -197,13 +224,12 @@ void DataGraph::dispEdge(int e) const
     cout << " -> ";
     dispNode(edge.dest());
     cout << " " << edge.time();
-    const auto &values = _edgeAttributes[e].stringValues();
-    for(const string &val : values)
-	cout << "," << val;
-    for(int val : _edgeAttributes[e].intValues())
-        cout << "," << val;
-    for(double val : _edgeAttributes[e].floatValues())
-        cout << "," << val;
+    for(int k=0; k<_edgeAttributes.numStringColumns(); k++)
+	cout << "," << _edgeAttributes.stringValue(k, e);
+    for(int k=0; k<_edgeAttributes.numIntColumns(); k++)
+        cout << "," << _edgeAttributes.intColumn(k)[e];
+    for(int k=0; k<_edgeAttributes.numFloatColumns(); k++)
+        cout << "," << _edgeAttributes.floatColumn(k)[e];
     cout << flush;
 }
 
@@ -226,19 +252,8 @@ void DataGraph::updateOrderedEdges() const
     // Make sure base class is updated first
     Graph::updateOrderedEdges();
     
-    // Clear old edge attributes
-    _edgeAttributes.clear();
-    
-    // Build edge list in chronological order
-    for(auto &pair : _timeEdgeAttributesMap)
-    {
-        time_t dateTime = pair.first;
-        const vector<Attributes> &attributes = _timeEdgeAttributesMap.find(dateTime)->second;
-        for(const Attributes &a : attributes)
-        {
-            _edgeAttributes.push_back(a);
-        }
-    }
+    // Put edge attributes in chronological order
+    _edgeAttributes.permute(EdgeColumnReorder{this});
 }
 
 
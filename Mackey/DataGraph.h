@@ -3,8 +3,10 @@
 
 #include "Attributes.h"
 #include "AttributesDef.h"
+#include "AttributesTable.h"
 #include "Graph.h"
 #include "GraphMatch.h"
+#include "StringPool.h"
 #include <unordered_map>
 #include <vector>
 
@@ -16,24 +18,35 @@ class DataGraph : public Graph
 {
 public:
     virtual void addNode(int v) override;
-    virtual void addNode(const std::string &name, const Attributes &a);
+    virtual void addNode(StringView name, const Attributes &a);
     virtual void addEdge(int u, int v) override;
     virtual void addEdge(int u, int v, time_t dateTime) override;
-    virtual void addEdge(const std::string &source, const std::string &dest, time_t dateTime, const Attributes &a);
+    virtual void addEdge(StringView source, StringView dest, time_t dateTime, const Attributes &a);
     virtual void copyEdge(int edgeIndex, const Graph &g) override;
     virtual void setNodeAttributesDef(const AttributesDef &def);
     virtual void setEdgeAttributesDef(const AttributesDef &def);
     //virtual void setNodeAttributes(int v, const Attributes &attributes);
     //virtual void setEdgeAttributes(int e, const Attributes &attributes);
     virtual DataGraph createSubGraph(const std::vector<GraphMatch> &matches) const;
-    virtual const std::string &getName(int v) const;
+    virtual StringView getName(int v) const;
     virtual void dispNode(int u) const;
     virtual void dispEdge(int e) const;
     virtual void disp() const;
-    const std::vector<Attributes> &nodeAttributes() const;
-    const std::vector<Attributes> &edgeAttributes() const;
+    /** Attributes of each node, in columns */
+    const AttributesTable &nodeAttributes() const;
+    /** Attributes of each edge (in chronological order), in columns */
+    const AttributesTable &edgeAttributes() const;
     const AttributesDef &nodeAttributesDef() const;
     const AttributesDef &edgeAttributesDef() const;
+    /**
+     * Re-encodes the string attributes of this (query) graph with the
+     * dictionaries of the graph it'll be searching, so they're compared as
+     * integers during the search.
+     * @param g  Graph that will be searched (or one sharing its dictionaries).
+     * @return  False if an exact string value isn't in g's dictionaries, so
+     * nothing in g can match it.
+     */
+    bool useDictionaries(const DataGraph &g);
     //const std::vector<std::string> &nodeAttributeNames() const;
     //const std::vector<std::string> &edgeAttributeNames() const;
 
@@ -41,12 +54,27 @@ protected:
     virtual void updateOrderedEdges() const override;
 
 private:
-    std::vector<std::string> _nodeNames;
-    std::unordered_map<std::string,int> _nodeNameMap;
+    friend class GraphSnapshot;
+    
+    // Node names, stored once each
+    StringPool _nodeNames;
+    // Name ID of each node (-1 if it has no name)
+    std::vector<int> _nodeNameIds;
+    // Node for each name ID
+    std::vector<int> _nameNodes;
     AttributesDef _nodeAttributesDef, _edgeAttributesDef;
-    std::vector<Attributes> _nodeAttributes;
-    std::map<time_t,std::vector<Attributes>> _timeEdgeAttributesMap;
-    mutable std::vector<Attributes> _edgeAttributes;
+    AttributesTable _nodeAttributes;
+    // Edge attributes in chronological order, followed by those of the edges
+    // added since the ordered edges were last updated
+    mutable AttributesTable _edgeAttributes;
+    
+    /** Puts each column of edge attributes in chronological order */
+    struct EdgeColumnReorder
+    {
+        const DataGraph *g;
+        template<typename T>
+        void operator()(std::vector<T> &values) const { g->reorderEdgeValues(values); }
+    };
 };
 
 #endif
@@ -0,0 +1,41 @@
+#include "DeltaCounts.h"
+
+using namespace std;
+
+DeltaCounts::DeltaCounts(const vector<time_t> &deltas) : _deltas(deltas), _bounds(deltas)
+{
+    std::sort(_bounds.begin(), _bounds.end());
+    _bounds.erase(std::unique(_bounds.begin(), _bounds.end()), _bounds.end());
+    // The last bin holds spans past every delta, which the search shouldn't find
+    _bins.assign(_bounds.size() + 1, 0);
+}
+
+void DeltaCounts::merge(const DeltaCounts &other)
+{
+    for(int i=0; i<(int)_bins.size(); i++)
+        _bins[i] += other._bins[i];
+}
+
+DeltaCounts DeltaCounts::empty() const
+{
+    DeltaCounts empty = *this;
+    empty._bins.assign(_bins.size(), 0);
+    return empty;
+}
+
+vector<long> DeltaCounts::counts() const
+{
+    // Number of matches with a span up to each bound
+    vector<long> totals(_bounds.size());
+    long total = 0;
+    for(int i=0; i<(int)_bounds.size(); i++)
+    {
+        total += _bins[i];
+        totals[i] = total;
+    }
+    
+    vector<long> counts;
+    for(time_t delta : _deltas)
+        counts.push_back(totals[std::lower_bound(_bounds.begin(), _bounds.end(), delta) - _bounds.begin()]);
+    return counts;
+}
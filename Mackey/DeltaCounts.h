@@ -0,0 +1,45 @@
+/*
+ * File:   DeltaCounts.h
+ * Author: D3M430
+ *
+ * Created on March 30, 2021, 2:20 PM
+ */
+
+#ifndef DELTACOUNTS_H
+#define	DELTACOUNTS_H
+
+#include <algorithm>
+#include <time.h>
+#include <vector>
+
+/**
+ * Counts matching subgraphs by their time span (from their earliest to
+ * their latest edge) for a list of delta values.  A match counts for every
+ * delta at least as long as its span, so one search with the largest delta
+ * gives the counts for all of them.
+ */
+class DeltaCounts
+{
+public:
+    DeltaCounts() {}
+    DeltaCounts(const std::vector<time_t> &deltas);
+    /** Largest of the delta values */
+    time_t maxDelta() const { return _bounds.empty() ? 0 : _bounds.back(); }
+    /** Counts a match with the given time span */
+    void add(time_t span) { _bins[std::lower_bound(_bounds.begin(), _bounds.end(), span) - _bounds.begin()]++; }
+    /** Adds the counts of another object with the same delta values (say, from another thread) */
+    void merge(const DeltaCounts &other);
+    /** Creates an object with the same delta values, and no matches counted */
+    DeltaCounts empty() const;
+    /** Number of matches within each delta value, in the order they were given */
+    std::vector<long> counts() const;
+
+private:
+    std::vector<time_t> _deltas;
+    // The delta values in increasing order, without duplicates, and the
+    // number of matches with a span up to each (but over the one before)
+    std::vector<time_t> _bounds;
+    std::vector<long> _bins;
+};
+
+#endif	/* DELTACOUNTS_H */
@@ -0,0 +1,90 @@
+/*
+ * File:   EdgeList.h
+ * Author: D3M430
+ *
+ * Created on March 4, 2021, 10:05 AM
+ */
+
+#ifndef EDGELIST_H
+#define	EDGELIST_H
+
+#include <time.h>
+#include "Column.h"
+#include "Edge.h"
+
+/**
+ * List of edges stored as separate source, dest and time columns, so that
+ * scans over many edges only touch the values they need.  Indexing it
+ * returns a lightweight Edge object built from the columns, where the
+ * index of the edge is its position in the list.
+ */
+class EdgeList
+{
+public:
+    /** Iterates over the edges, returning each as an Edge */
+    class const_iterator
+    {
+    public:
+        const_iterator(const EdgeList *edges, int i) : _edges(edges), _i(i) {}
+        Edge operator*() const { return (*_edges)[_i]; }
+        const_iterator &operator++() { _i++; return *this; }
+        const_iterator &operator--() { _i--; return *this; }
+        const_iterator &operator+=(int n) { _i += n; return *this; }
+        const_iterator operator+(int n) const { return const_iterator(_edges, _i+n); }
+        int operator-(const const_iterator &rhs) const { return _i - rhs._i; }
+        bool operator==(const const_iterator &rhs) const { return _i == rhs._i; }
+        bool operator!=(const const_iterator &rhs) const { return _i != rhs._i; }
+    private:
+        const EdgeList *_edges;
+        int _i;
+    };
+
+    /** Adds an edge to the end of the list */
+    void push_back(int source, int dest, time_t dateTime)
+    {
+        _sources.push_back(source);
+        _dests.push_back(dest);
+        _times.push_back(dateTime);
+    }
+    /** Makes room for the given number of edges */
+    void reserve(int m)
+    {
+        _sources.reserve(m);
+        _dests.reserve(m);
+        _times.reserve(m);
+    }
+    /** Uses the given columns of m edges without copying them.  They must outlive this list. */
+    void borrow(const int *sources, const int *dests, const time_t *times, int m)
+    {
+        _sources.borrow(sources, m);
+        _dests.borrow(dests, m);
+        _times.borrow(times, m);
+    }
+    /** Removes all edges */
+    void clear()
+    {
+        _sources.clear();
+        _dests.clear();
+        _times.clear();
+    }
+    /** Gets the edge at the given index */
+    Edge operator[](int i) const { return Edge(i, _sources[i], _dests[i], _times[i]); }
+    Edge front() const { return (*this)[0]; }
+    Edge back() const { return (*this)[size()-1]; }
+    int size() const { return _sources.size(); }
+    bool empty() const { return _sources.empty(); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, size()); }
+    /** Source node of each edge */
+    const Column<int> &sources() const { return _sources; }
+    /** Destination node of each edge */
+    const Column<int> &dests() const { return _dests; }
+    /** Date/time of each edge */
+    const Column<time_t> &times() const { return _times; }
+private:
+    Column<int> _sources, _dests;
+    Column<time_t> _times;
+};
+
+#endif	/* EDGELIST_H */
+
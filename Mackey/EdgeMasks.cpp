@@ -0,0 +1,24 @@
+#include "EdgeMasks.h"
+
+using namespace std;
+
+void EdgeMasks::reset(int numQueryEdges)
+{
+    if(numQueryEdges > MAX_QUERY_EDGES)
+        throw "The query has too many edges for edge masks.";
+    _masks.clear();
+    _edges.assign(numQueryEdges, vector<int>());
+    _times.assign(numQueryEdges, vector<time_t>());
+}
+
+void EdgeMasks::push(time_t time, Mask mask)
+{
+    int g_e = _masks.size();
+    _masks.push_back(mask);
+    for(Mask rest = mask; rest != 0; rest &= rest - 1)
+    {
+        int h_i = __builtin_ctzll(rest);
+        _edges[h_i].push_back(g_e);
+        _times[h_i].push_back(time);
+    }
+}
@@ -0,0 +1,95 @@
+/*
+ * File:   EdgeMasks.h
+ * Author: D3M430
+ *
+ * Created on April 7, 2021, 1:20 PM
+ */
+
+#ifndef EDGEMASKS_H
+#define	EDGEMASKS_H
+
+#include "EdgeRange.h"
+#include "Graph.h"
+#include <stdint.h>
+#include <time.h>
+#include <vector>
+
+/**
+ * Which query edges each edge of the searched graph meets the criteria of,
+ * as a bitmask with one bit per query edge, and the list of edges that
+ * meet the criteria of each query edge (in edge order, with their times).
+ * It's all worked out in one pass over the edges, so a search can test the
+ * criteria with a single AND, and only look through the edges that meet
+ * them when it has nothing else to go on.  Only works for queries with up
+ * to MAX_QUERY_EDGES edges.
+ */
+class EdgeMasks
+{
+public:
+    typedef uint64_t Mask;
+    /** Most query edges there can be a bit for */
+    static const int MAX_QUERY_EDGES = 64;
+
+    /** True if h is small enough to have a bit for each edge */
+    static bool fits(const Graph &h) { return h.numEdges() <= MAX_QUERY_EDGES; }
+
+    /**
+     * Tests every edge of g against every edge of h.  The criteria's class
+     * is a parameter, so final classes (like MatchCriteria_Labels) are
+     * inlined into the loop.
+     * @param g  The graph that will be searched.
+     * @param h  The query graph (which must fit).
+     * @param criteria  Criteria for the query graph.
+     */
+    template<typename Criteria>
+    void compute(const Graph &g, const Graph &h, const Criteria &criteria);
+
+    /** Starts over, for a query with the given number of edges (which must fit) */
+    void reset(int numQueryEdges);
+    /** Adds the next edge of the searched graph, with its time, and the query edges it meets the criteria of */
+    void push(time_t time, Mask mask);
+
+    /** Number of edges of the searched graph */
+    int numEdges() const { return _masks.size(); }
+    /** Number of edges of the query */
+    int numQueryEdges() const { return _edges.size(); }
+    /** True if the masks were worked out for these graphs (by their numbers of edges) */
+    bool covers(const Graph &g, const Graph &h) const { return numEdges() == g.numEdges() && numQueryEdges() == h.numEdges(); }
+    /** Masks of all the edges of the searched graph, in edge order */
+    const Mask *masks() const { return _masks.data(); }
+    /** Query edges that edge g_e of the searched graph meets the criteria of */
+    Mask mask(int g_e) const { return _masks[g_e]; }
+    /** True if edge g_e of the searched graph meets the criteria of query edge h_i */
+    bool matches(int g_e, int h_i) const { return (_masks[g_e] >> h_i) & 1; }
+    /** Edges that meet the criteria of query edge h_i, in edge order */
+    EdgeRange edges(int h_i) const { return _edges[h_i]; }
+    /** Times of the edges that meet the criteria of query edge h_i */
+    const std::vector<time_t> &times(int h_i) const { return _times[h_i]; }
+
+private:
+    std::vector<Mask> _masks;
+    std::vector<std::vector<int>> _edges;
+    std::vector<std::vector<time_t>> _times;
+};
+
+template<typename Criteria>
+void EdgeMasks::compute(const Graph &g, const Graph &h, const Criteria &criteria)
+{
+    int m = g.numEdges();
+    int k = h.numEdges();
+    const time_t *times = g.edges().times().data();
+    reset(k);
+    _masks.reserve(m);
+    for(int g_e=0; g_e<m; g_e++)
+    {
+        Mask mask = 0;
+        for(int h_i=0; h_i<k; h_i++)
+        {
+            if(criteria.isEdgeMatch(g, g_e, h, h_i))
+                mask |= Mask(1) << h_i;
+        }
+        push(times[g_e], mask);
+    }
+}
+
+#endif	/* EDGEMASKS_H */
@@ -0,0 +1,38 @@
+/*
+ * File:   EdgeRange.h
+ * Author: D3M430
+ *
+ * Created on March 2, 2021, 9:12 AM
+ */
+
+#ifndef EDGERANGE_H
+#define	EDGERANGE_H
+
+#include <vector>
+#include "Column.h"
+
+/**
+ * Read-only view of a contiguous list of edge indexes, which lives inside
+ * one of the graph's flat index arrays.  Cheap to copy, and only valid
+ * until the graph's edges are rebuilt.
+ */
+class EdgeRange
+{
+public:
+    EdgeRange() : _begin(nullptr), _end(nullptr) {}
+    EdgeRange(const int *begin, const int *end) : _begin(begin), _end(end) {}
+    EdgeRange(const std::vector<int> &edges) : _begin(edges.data()), _end(edges.data() + edges.size()) {}
+    EdgeRange(const Column<int> &edges) : _begin(edges.data()), _end(edges.data() + edges.size()) {}
+    const int *begin() const { return _begin; }
+    const int *end() const { return _end; }
+    int size() const { return (int)(_end - _begin); }
+    bool empty() const { return _begin == _end; }
+    int operator[](int i) const { return _begin[i]; }
+    int front() const { return *_begin; }
+    int back() const { return *(_end-1); }
+private:
+    const int *_begin, *_end;
+};
+
+#endif	/* EDGERANGE_H */
+
@@ -2,6 +2,7 @@
 #include "LabeledWeightedGraph.h"
 #include "FastReader.h"
 #include "GraphMatch.h"
+#include "GraphSnapshot.h"
 #include "SearchConfig.h"
 #include <dirent.h>
 #include <sys/stat.h>
@@ -635,10 +636,10 @@ void FileIO::saveGenericGDF(const DataGraph &g, const string &fname)
     int numEdgeAtts = edgeDef.attributeNames().size();
     
     // Save node data
+    const AttributesTable &nodeTable = g.nodeAttributes();
     int n = g.nodes().size();
     for(int u=0; u<n; u++)
     {
-        const Attributes &a = g.nodeAttributes()[u];
         int si=0, ii=0, fi=0; // Indices into string values, int values, float values
 	for(int i=0; i<numNodeAtts; i++)
 	{
@@ -648,17 +649,17 @@ void FileIO::saveGenericGDF(const DataGraph &g, const string &fname)
                 DataType dataType = nodeDef.dataTypes()[i];       
                 if(dataType == DataType::STRING)
                 {
-                    ofs << a.stringValues()[si];
+                    ofs << nodeTable.stringValue(si, u);
                     si++;
                 }
                 else if(dataType == DataType::INT)
                 {
-                    ofs << a.intValues()[ii];
+                    ofs << nodeTable.intColumn(ii)[u];
                     ii++;
                 }
                 else if(dataType == DataType::FLOAT)
                 {
-                    ofs << a.floatValues()[fi];
+                    ofs << nodeTable.floatColumn(fi)[u];
                     fi++;
                 }
                 else
@@ -683,11 +684,11 @@ void FileIO::saveGenericGDF(const DataGraph &g, const string &fname)
     FileIO::saveAttributesHeader(g.edgeAttributesDef(), ofs);
 
     // Save edge data
+    const AttributesTable &edgeTable = g.edgeAttributes();
     int m = g.numEdges();
     for(int e=0; e<m; e++)
     {
         const Edge &edge = g.edges()[e];
-	const Attributes &a = g.edgeAttributes()[e];
         int si=0, ii=0, fi=0; // Indices into string values, int values, float values
 	for(int i=0; i<numEdgeAtts; i++)
 	{
@@ -697,17 +698,17 @@ void FileIO::saveGenericGDF(const DataGraph &g, const string &fname)
                 DataType dataType = edgeDef.dataTypes()[i];
                 if(dataType == DataType::STRING)
                 {
-                    ofs << a.stringValues()[si];
+                    ofs << edgeTable.stringValue(si, e);
                     si++;
                 }
                 else if(dataType == DataType::INT)
                 {
-                    ofs << a.intValues()[ii];
+                    ofs << edgeTable.intColumn(ii)[e];
                     ii++;
                 }
                 else if(dataType == DataType::FLOAT)
                 {
-                    ofs << a.floatValues()[fi];
+                    ofs << edgeTable.floatColumn(fi)[e];
                     fi++;
                 }
                 else
@@ -738,6 +739,16 @@ void FileIO::saveGenericGDF(const DataGraph &g, const string &fname)
     ofs.close();
 }
 
+DataGraph FileIO::loadSnapshot(const string &fname)
+{
+    return GraphSnapshot::load(fname);
+}
+
+void FileIO::saveSnapshot(const DataGraph &g, const string &fname)
+{
+    GraphSnapshot::save(g, fname);
+}
+
 void FileIO::saveNodeCount(const LabeledWeightedGraph &g, const vector<GraphMatch> &subgraphs, 
 			   const LabeledWeightedGraph &h, const unordered_map<string,vector<int>> &timeCounts, 
 			   int numTimeSlices, time_t startTime, time_t endTime, const string &fname)
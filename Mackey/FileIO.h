@@ -95,6 +95,16 @@ public:
      * @param fname  Name of GDF file to save it to.
      */
     static void saveGenericGDF(const DataGraph &g, const std::string &fname);
+    /**
+     * Loads a data graph from a binary snapshot created by saveSnapshot.
+     * The file is memory mapped, and its edges and indexes are used in place.
+     */
+    static DataGraph loadSnapshot(const std::string &fname);
+    /**
+     * Saves the data graph (along with its indexes) as a binary snapshot,
+     * so it can be loaded quickly later on.
+     */
+    static void saveSnapshot(const DataGraph &g, const std::string &fname);
 
     /**
      * Saves a CSV file with the number of times each node is encountered
@@ -21,6 +21,7 @@ Graph::Graph(int windowDuration)
 
 void Graph::addNode(int v)
 {
+    checkNotFrozen();
     if(v >= _nodes.size())
         _nodes.resize(v+1);
 }
@@ -35,6 +36,7 @@ void Graph::addEdge(int u, int v, time_t dateTime)
     // No self loops for now
     //if(u == v)
         //throw "No self loops allowed";
+    checkNotFrozen();
     if(u < 0 || v < 0)
         throw "Vertices must be >= 0";
     
@@ -44,8 +46,11 @@ void Graph::addEdge(int u, int v, time_t dateTime)
     if(_nodes.size() < min_n)
         _nodes.resize(min_n);
     
-    // Add to the sorted map, based on time
-    _timeEdgeMap[dateTime].push_back(Edge(_numEdges,u,v,dateTime));
+    // Just append for now; the edges are sorted by time all at once when updated
+    _newEdges.push_back(u,v,dateTime);
+    // An edge from before the last ordered one means we need to reorder everything
+    if(!_edges.empty() && dateTime < _edges.times().back())
+        _outOfOrderEdges = true;
     _numEdges++;
     
     _edgesReady = false;
@@ -79,22 +84,42 @@ bool Graph::hasEdge(int u, int v) const
 {
     if(!_edgesReady)
         this->updateOrderedEdges();
+    if(!_pairIndexReady)
+        this->updatePairIndex();
     
-    return _nodeEdges.find(u) != _nodeEdges.end() && _nodeEdges[u].find(v) != _nodeEdges[u].end();
+    return findPair(u, v) >= 0;
 }
 
-const vector<int> &Graph::getEdgeIndexes(int u, int v) const
+EdgeRange Graph::getEdgeIndexes(int u, int v) const
 {
     if(!_edgesReady)
         this->updateOrderedEdges();
+    if(!_pairIndexReady)
+        this->updatePairIndex();
     
-    if(!hasEdge(u,v))
+    int p = findPair(u, v);
+    if(p < 0)
         throw "There are no edges between the vertices selected.";
     
-    return _nodeEdges[u][v];
+    const int *pairEdges = _pairEdges.data();
+    return EdgeRange(pairEdges + _pairEdgeOffsets[p], pairEdges + _pairEdgeOffsets[p+1]);
 }
 
-const vector<Edge> &Graph::edges() const
+int Graph::findPair(int u, int v) const
+{
+    if(u < 0 || u+1 >= _pairOffsets.size())
+        return -1;
+    
+    // Binary search over the sorted dest nodes of u
+    auto first = _pairDests.begin() + _pairOffsets[u];
+    auto last = _pairDests.begin() + _pairOffsets[u+1];
+    auto it = std::lower_bound(first, last, v);
+    if(it == last || *it != v)
+        return -1;
+    return it - _pairDests.begin();
+}
+
+const EdgeList &Graph::edges() const
 {
     if(!_edgesReady)
     {
@@ -103,6 +128,21 @@ const vector<Edge> &Graph::edges() const
     return _edges;
 }
 
+void Graph::freeze()
+{
+    if(!_edgesReady)
+        this->updateOrderedEdges();
+    if(!_pairIndexReady)
+        this->updatePairIndex();
+    _frozen = true;
+}
+
+void Graph::checkNotFrozen() const
+{
+    if(_frozen)
+        throw "The graph is frozen, and can't be modified.";
+}
+
 void Graph::disp() const
 {
     if(!_edgesReady)
@@ -143,65 +183,176 @@ void Graph::dispDateTimeRange() const
     cout << "Current Window End Date/Time: (" << wEnd << ") " << asctime(wEndTM);
 }
 
+void Graph::sortByTime(const vector<time_t> &times, vector<int> &order)
+{
+    int m = times.size();
+    order.resize(m);
+    for(int i=0; i<m; i++)
+        order[i] = i;
+    
+    // Most data files are already in chronological order, so check for that first
+    bool isSorted = true;
+    for(int i=1; i<m && isSorted; i++)
+        isSorted = times[i-1] <= times[i];
+    if(isSorted)
+        return;
+    
+    // Stable LSD radix sort, 16 bits at a time.  Flipping the sign bit makes
+    // the signed times sort correctly as unsigned keys.
+    const int RADIX_BITS = 16;
+    const int NUM_BUCKETS = 1 << RADIX_BITS;
+    const unsigned long long SIGN_BIT = 1ULL << 63;
+    vector<unsigned long long> keys(m), keys2(m);
+    for(int i=0; i<m; i++)
+        keys[i] = (unsigned long long)times[i] ^ SIGN_BIT;
+    vector<int> order2(m);
+    vector<int> counts(NUM_BUCKETS);
+    for(int shift=0; shift<64; shift+=RADIX_BITS)
+    {
+        std::fill(counts.begin(), counts.end(), 0);
+        for(int i=0; i<m; i++)
+            counts[(keys[i] >> shift) & (NUM_BUCKETS-1)]++;
+        // Skip this digit if every key has the same value for it
+        if(counts[(keys[0] >> shift) & (NUM_BUCKETS-1)] == m)
+            continue;
+        int total = 0;
+        for(int b=0; b<NUM_BUCKETS; b++)
+        {
+            int count = counts[b];
+            counts[b] = total;
+            total += count;
+        }
+        for(int i=0; i<m; i++)
+        {
+            int pos = counts[(keys[i] >> shift) & (NUM_BUCKETS-1)]++;
+            keys2[pos] = keys[i];
+            order2[pos] = order[i];
+        }
+        keys.swap(keys2);
+        order.swap(order2);
+    }
+}
+
 void Graph::updateOrderedEdges() const
 {
 //    cout << "Sorting edges chronologically." << endl;
     
-    int n = _nodes.size();
+    // If every edge added since the last update happened at or after the
+    // last ordered edge, the new edges can just be appended in order.
+    // Otherwise, everything needs to be reordered.
+    int numPrev = _edges.size();
+    int start = _outOfOrderEdges ? 0 : numPrev;
+    
+    // Determine the chronological order of the edges being placed: the
+    // previously ordered ones (if reordering everything), followed by the new
+    // ones in the order they were added.  The sort is stable, so ties stay in
+    // the order they were added.
+    vector<time_t> times;
+    times.reserve(numPrev - start + _newEdges.size());
+    times.insert(times.end(), _edges.times().begin() + start, _edges.times().end());
+    times.insert(times.end(), _newEdges.times().begin(), _newEdges.times().end());
+    sortByTime(times, _edgeOrder);
+    for(int &i : _edgeOrder)
+        i += start;
     
     // Clear old edges
-    _edges.clear();
-    for(Node &node : _nodes)
+    EdgeList prevEdges;
+    if(start == 0)
     {
-        node.edges().clear();
-        node.outEdges().clear();
-        node.inEdges().clear();
+        prevEdges = std::move(_edges);
+        _edges.clear();
+        for(Node &node : _nodes)
+        {
+            node.edges().clear();
+            node.outEdges().clear();
+            node.inEdges().clear();
+            node.outEdgeTimes().clear();
+            node.inEdgeTimes().clear();
+        }
     }
     
     // Build edge list in chronological order
-    int edge_index = 0;
-    for(auto &pair : _timeEdgeMap)
+    int m = start + _edgeOrder.size();
+    if(start == 0)
+        _edges.reserve(m);
+    for(int edge_index=start; edge_index<m; edge_index++)
     {
-        time_t dateTime = pair.first;
-        const vector<Edge> &edges = _timeEdgeMap.find(dateTime)->second;
-        for(const Edge &edge : edges)
-        {
-            // Create new edge now that we know the time index
-            Edge newEdge(edge_index, edge.source(), edge.dest(), edge.time());
-            _edges.push_back(newEdge);
-            _edgeTimes.push_back(dateTime);
-            
-            int u = edge.source(), v = edge.dest();
-            
-            _nodes[u].edges().push_back(edge_index);
-            _nodes[v].edges().push_back(edge_index);
-            _nodes[u].outEdges().push_back(edge_index);
-            _nodes[v].inEdges().push_back(edge_index);
-            
-            edge_index++;
-        }
+        // Copy the edge to its chronological position
+        int i = _edgeOrder[edge_index-start];
+        Edge edge = i < numPrev ? prevEdges[i] : _newEdges[i-numPrev];
+        int u = edge.source(), v = edge.dest();
+        time_t t = edge.time();
+        _edges.push_back(u, v, t);
+        
+        _nodes[u].edges().push_back(edge_index);
+        _nodes[v].edges().push_back(edge_index);
+        _nodes[u].outEdges().push_back(edge_index);
+        _nodes[v].inEdges().push_back(edge_index);
+        _nodes[u].outEdgeTimes().push_back(t);
+        _nodes[v].inEdgeTimes().push_back(t);
     }
     
-    // Setup nodeEdges map    
-    this->_nodeEdges.clear();
+    _newEdges.clear();
+    _numPrevEdges = numPrev;
+    _firstUpdatedEdge = start;
+    _outOfOrderEdges = false;
+    
+    // Index of edges between each pair of nodes is rebuilt when it's next needed
+    _pairIndexReady = false;
+    
+    // Make sure we flag the edges as ready now, so we don't redo this every time
+    _edgesReady = true;
+}
+
+void Graph::updatePairIndex() const
+{
+    int n = _nodes.size();
+    
+    vector<int> pairOffsets(n+1, 0);
+    vector<int> pairDests;
+    vector<int> pairEdgeOffsets;
+    vector<int> pairEdges;
+    pairEdges.reserve(_edges.size());
+    
+    // Group the out edges of each node by their dest node.  The sort is stable,
+    // so the edges of each pair stay in chronological order.
+    vector<int> outEdges;
+    const Column<int> &dests = _edges.dests();
     for(int u=0; u<n; u++)
     {
-        const Node &node = _nodes[u];
-        for(int e : node.outEdges())            
+        pairOffsets[u] = pairDests.size();
+        const Column<int> &nodeEdges = _nodes[u].outEdges();
+        outEdges.assign(nodeEdges.begin(), nodeEdges.end());
+        std::stable_sort(outEdges.begin(), outEdges.end(), [&dests](int e1, int e2)
+        {
+            return dests[e1] < dests[e2];
+        });
+        int prevDest = -1;
+        for(int e : outEdges)
         {
-            const Edge &edge = _edges[e];
-            int v = edge.dest();
-            _nodeEdges[u][v].push_back(e);
+            int v = dests[e];
+            if(v != prevDest)
+            {
+                pairDests.push_back(v);
+                pairEdgeOffsets.push_back(pairEdges.size());
+                prevDest = v;
+            }
+            pairEdges.push_back(e);
         }
     }
+    pairOffsets[n] = pairDests.size();
+    pairEdgeOffsets.push_back(pairEdges.size());
     
-    // Make sure we flag the edges as ready now, so we don't redo this every time
-    _edgesReady = true;
+    _pairOffsets = std::move(pairOffsets);
+    _pairDests = std::move(pairDests);
+    _pairEdgeOffsets = std::move(pairEdgeOffsets);
+    _pairEdges = std::move(pairEdges);
+    _pairIndexReady = true;
 }
 
 time_t Graph::windowStart() const
 {
-    time_t dataStart = _edgeTimes.front();
+    time_t dataStart = _edges.times().front();
     if(dataStart > _windowStart)
 	return dataStart;
     return _windowStart;
@@ -209,7 +360,7 @@ time_t Graph::windowStart() const
 
 time_t Graph::windowEnd() const
 {
-    time_t dataEnd = _edgeTimes.back();
+    time_t dataEnd = _edges.times().back();
     if(dataEnd < _windowEnd)
 	return dataEnd;
     return _windowEnd;
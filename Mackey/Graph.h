@@ -8,12 +8,16 @@
 #ifndef GRAPH_H
 #define	GRAPH_H
 
+#include <memory>
 #include <vector>
 #include <map>
 #include <unordered_map>
 #include <time.h>
+#include "Column.h"
 #include "Node.h"
 #include "Edge.h"
+#include "EdgeList.h"
+#include "EdgeRange.h"
 
 /**
  * Our standard, directed graph, where edges are listed in the order they
@@ -35,19 +39,28 @@ public:
     /** Copies the given edge from another graph (useful for making sure metadata is consistent */
     virtual void copyEdge(int edgeIndex, const Graph &g);
     /** Returns false if no edge exists between the vertices */    
-    virtual bool hasEdge(int u, int v) const;
-    /** Returns a list of all edges between the two points (directed) */    
-    virtual const std::vector<int> &getEdgeIndexes(int u, int v) const;
+    bool hasEdge(int u, int v) const;
+    /** Returns a list of all edges between the two points (directed), in chronological order */    
+    EdgeRange getEdgeIndexes(int u, int v) const;
     /** Creates a subgraph from the given set of nodes */
     //virtual Graph createSubGraph(const std::vector<int> &nodes);
     /** List of all nodes in the graph */
-    virtual const std::vector<Node> &nodes() const { return _nodes; }
+    const std::vector<Node> &nodes() const { return _nodes; }
     /** Ordered list of all edges (sorted by order of occurrence) */
-    virtual const std::vector<Edge> &edges() const;
+    const EdgeList &edges() const;
     /** Gets the number of nodes (without having to sort anything) */
-    virtual int numNodes() const { return _nodes.size(); }
+    int numNodes() const { return _nodes.size(); }
     /** Gets the number of edges (without having to sort anything) */
-    virtual int numEdges() const { return _numEdges; }
+    int numEdges() const { return _numEdges; }
+    /** 
+     * Builds all of the indexes that are normally built on demand, and stops
+     * any more nodes or edges from being added.  Once frozen, none of the const
+     * methods modify anything, so the graph can be searched from many threads
+     * at once.
+     */
+    void freeze();
+    /** True if freeze() has been called, so the graph can't be modified */
+    bool frozen() const { return _frozen; }
     /** Displays all graph contents */
     virtual void disp() const;
     /** Displays the contents of the given edge */
@@ -64,20 +77,116 @@ public:
     time_t windowEnd() const;// { return _windowEnd; }
 protected:    
     virtual void updateOrderedEdges() const;
+    /** Builds the compressed sparse row index of the (source,dest) node pairs */
+    void updatePairIndex() const;
+    /** Index of the (u,v) pair in the pair index, or -1 if there are no edges between them */
+    int findPair(int u, int v) const;
+    /**
+     * Puts per-edge metadata kept by subclasses in the same chronological order
+     * as the edges, after the last update of the ordered edges.
+     * @param values  (INPUT/OUTPUT) Values for the previously ordered edges, in chronological order.
+     * @param newValues  (INPUT) Values for the edges added since, in the order they were added.
+     * Cleared once they've been moved into values.
+     */
+    template<typename T>
+    void reorderEdgeValues(std::vector<T> &values, std::vector<T> &newValues) const;
+    /**
+     * Same as above, but for per-edge metadata kept in a single array, with
+     * the values of the new edges already on the end.
+     * @param values  (INPUT/OUTPUT) Values for the previously ordered edges, in chronological order,
+     * followed by the values for the edges added since, in the order they were added.
+     */
+    template<typename T>
+    void reorderEdgeValues(std::vector<T> &values) const;
+    /** Throws an exception if the graph is frozen */
+    void checkNotFrozen() const;
     // Flag to determine if we've built our complete list of edges yet
     mutable bool _edgesReady;    
     
 private:
+    // Reads and writes the internal arrays directly
+    friend class GraphSnapshot;
+
+    /** Stable sort by time.  Fills order with the indexes of the given
+     * times, in chronological order. */
+    static void sortByTime(const std::vector<time_t> &times, std::vector<int> &order);
+    
     int _numEdges = 0;
+    bool _frozen = false;
     mutable std::vector<Node> _nodes;
     int _windowDuration;
     time_t _windowStart, _windowEnd;
-    // Ordered map, by date/time
-    std::map<time_t,std::vector<Edge>> _timeEdgeMap;
-    mutable std::vector<time_t> _edgeTimes;
-    mutable std::vector<Edge> _edges;
-    mutable std::unordered_map<int,std::unordered_map<int,std::vector<int>>> _nodeEdges;
+    // Edges added since the ordered edges were last updated, in the order they were added
+    mutable EdgeList _newEdges;
+    // Set if any of the new edges happened before the last ordered edge
+    mutable bool _outOfOrderEdges = false;
+    // How the last update ordered the edges.  Chronological edge e (for
+    // e >= _firstUpdatedEdge) came from _edgeOrder[e-_firstUpdatedEdge], where
+    // indexes below _numPrevEdges are previously ordered edges and the rest
+    // are new edges (offset by _numPrevEdges).
+    mutable std::vector<int> _edgeOrder;
+    mutable int _firstUpdatedEdge = 0;
+    mutable int _numPrevEdges = 0;
+    // All edges that have been put in chronological order
+    mutable EdgeList _edges;
+    // Compressed sparse row index of the edges between each pair of nodes.
+    // The dest nodes of source u are _pairDests[_pairOffsets[u].._pairOffsets[u+1]]
+    // (sorted), and the edges of pair p are _pairEdges[_pairEdgeOffsets[p].._pairEdgeOffsets[p+1]]
+    // (chronological).
+    mutable Column<int> _pairOffsets;
+    mutable Column<int> _pairDests;
+    mutable Column<int> _pairEdgeOffsets;
+    mutable Column<int> _pairEdges;
+    mutable bool _pairIndexReady = false;
+    // Memory mapped snapshot the columns above may be borrowing from, if the
+    // graph was loaded from one
+    std::shared_ptr<const void> _snapshot;
 };
 
-#endif	/* GRAPH_H */
+template<typename T>
+void Graph::reorderEdgeValues(std::vector<T> &values, std::vector<T> &newValues) const
+{
+    int m = _firstUpdatedEdge + _edgeOrder.size();
+    if(_firstUpdatedEdge < _numPrevEdges)
+    {
+        // Everything was reordered, so start over from the old values
+        std::vector<T> prevValues;
+        prevValues.swap(values);
+        values.reserve(m);
+        for(int e=0; e<m; e++)
+        {
+            int i = _edgeOrder[e];
+            if(i < _numPrevEdges)
+                values.push_back(std::move(prevValues[i]));
+            else
+                values.push_back(std::move(newValues[i-_numPrevEdges]));
+        }
+    }
+    else
+    {
+        // New edges were just appended
+        for(int e=_firstUpdatedEdge; e<m; e++)
+            values.push_back(std::move(newValues[_edgeOrder[e-_firstUpdatedEdge]-_numPrevEdges]));
+    }
+    newValues.clear();
+}
 
+template<typename T>
+void Graph::reorderEdgeValues(std::vector<T> &values) const
+{
+    // Edge order indexes are the same as the positions in values, so only
+    // the updated range needs to be shuffled (if the order changed at all)
+    int numUpdated = _edgeOrder.size();
+    bool inOrder = true;
+    for(int j=0; j<numUpdated && inOrder; j++)
+        inOrder = _edgeOrder[j] == _firstUpdatedEdge + j;
+    if(inOrder)
+        return;
+    std::vector<T> orderedValues;
+    orderedValues.reserve(numUpdated);
+    for(int i : _edgeOrder)
+        orderedValues.push_back(std::move(values[i]));
+    std::move(orderedValues.begin(), orderedValues.end(), values.begin() + _firstUpdatedEdge);
+}
+
+#endif	/* GRAPH_H */
@@ -36,6 +36,38 @@ void GraphFilter::filter(const Graph& g, const Graph& h, const MatchCriteria& cr
     }
 }
 
+void GraphFilter::filter(const Graph &g, const Graph &h, const MatchCriteria &criteria, Graph &g2, EdgeMasks &masks)
+{
+    if(!EdgeMasks::fits(h))
+    {
+        masks = EdgeMasks();
+        filter(g, h, criteria, g2);
+        return;
+    }
+    
+    // Test each edge against all of the query edges, keeping the ones that
+    // match at least one.  The edges are copied in order, so the copies are
+    // in the same (chronological) order, and get the masks in that order.
+    int g_m = g.numEdges();
+    int h_m = h.numEdges();
+    const time_t *times = g.edges().times().data();
+    masks.reset(h_m);
+    for(int g_i=0; g_i<g_m; g_i++)
+    {
+        EdgeMasks::Mask mask = 0;
+        for(int h_i=0; h_i<h_m; h_i++)
+        {
+            if(criteria.isEdgeMatch(g, g_i, h, h_i))
+                mask |= EdgeMasks::Mask(1) << h_i;
+        }
+        if(mask != 0)
+        {
+            g2.copyEdge(g_i, g);
+            masks.push(times[g_i], mask);
+        }
+    }
+}
+
 void GraphFilter::filter(const CertGraph &g, const CertGraph &h, const MatchCriteria &criteria, CertGraph &g2)
 {
     //cout << "Filtering graph" << endl;
@@ -118,9 +150,9 @@ void GraphFilter::filter(const CertGraph &g, const CertGraph &h, const MatchCrit
 
 void GraphFilter::filter(const CertGraph &g, time_t start, time_t end, CertGraph &g2)
 {
-    const vector<Edge> &edges = g.edges();
+    const EdgeList &edges = g.edges();
     // Try all edges
-    for(const Edge &edge : edges)
+    for(Edge edge : edges)
     {
 	time_t t = edge.time();
 	// Only copy those in the date/time range
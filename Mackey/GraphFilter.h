@@ -10,6 +10,7 @@
 
 #include "Graph.h"
 #include "CertGraph.h"
+#include "EdgeMasks.h"
 #include "MatchCriteria.h"
 
 /**
@@ -28,6 +29,18 @@ public:
      * @param g2  Empty graph to have nodes/edges added to it, based on the criteria.
      */
     static void filter(const Graph &g, const Graph &h, const MatchCriteria &criteria, Graph &g2);
+    /**
+     * Same as above, but also keeps which query edges each copied edge
+     * matches, so the search doesn't test them again (see
+     * GraphSearch::setEdgeMasks).  The masks are left empty if the query
+     * has too many edges for them.
+     * @param g  Graph we are copying/filtering.
+     * @param h  Query graph that we will be using.
+     * @param criteria  Criteria for the query graph.
+     * @param g2  Empty graph to have nodes/edges added to it, based on the criteria.
+     * @param masks  Set to the query edges each edge of g2 matches.
+     */
+    static void filter(const Graph &g, const Graph &h, const MatchCriteria &criteria, Graph &g2, EdgeMasks &masks);
     /**
      * Creates a copy of a given CERT graph by filtering out edges that don't match
      * any of the query edges, given a query graph and the criteria.
@@ -1,15 +1,158 @@
 #include <limits.h>
+#include <algorithm>
+#include <limits>
 #include <unordered_set>
 #include <unordered_map>
 #include <stack>
 #include <iostream>
+#include <random>
+#include <thread>
+#include <typeinfo>
+#include <utility>
 #include "GraphSearch.h"
 #include "Graph.h"
 #include "Edge.h"
+#include "CandidateScan.h"
+#include "EdgeMasks.h"
+#include "MatchCriteria_DataGraph.h"
+#include "MatchCriteria_Labels.h"
+#include "SmallQuerySearch.h"
+#include "TemporalRISearch.h"
+#include "WorkStealingPool.h"
 #include <limits.h>
 
 using namespace std;
 
+namespace
+{
+    /** Searches with the kernel for queries with NumEdges edges, if h fits it */
+    template<int NumEdges>
+    bool searchSmall(const Graph &g, const Graph &h, const EdgeMasks &masks, int delta, const NodeDomains &domains,
+        MatchOutput *output, DeltaCounts *deltaCounts, int numThreads, long &numOccs)
+    {
+        typedef SmallQuerySearch<NumEdges, NumEdges+1> Kernel;
+        if(!Kernel::fits(h))
+            return false;
+        Kernel search(g, h, masks, delta, domains, output, deltaCounts);
+        numOccs = search.run(numThreads);
+        return true;
+    }
+
+    /** Searches with the kernel sized for h, if there is one (returning false otherwise) */
+    bool searchSmallQuery(const Graph &g, const Graph &h, const EdgeMasks &masks, int delta, const NodeDomains &domains,
+        MatchOutput *output, DeltaCounts *deltaCounts, int numThreads, long &numOccs)
+    {
+        switch(h.numEdges())
+        {
+        case 1: return searchSmall<1>(g, h, masks, delta, domains, output, deltaCounts, numThreads, numOccs);
+        case 2: return searchSmall<2>(g, h, masks, delta, domains, output, deltaCounts, numThreads, numOccs);
+        case 3: return searchSmall<3>(g, h, masks, delta, domains, output, deltaCounts, numThreads, numOccs);
+        case 4: return searchSmall<4>(g, h, masks, delta, domains, output, deltaCounts, numThreads, numOccs);
+        case 5: return searchSmall<5>(g, h, masks, delta, domains, output, deltaCounts, numThreads, numOccs);
+        case 6: return searchSmall<6>(g, h, masks, delta, domains, output, deltaCounts, numThreads, numOccs);
+        default: return false;
+        }
+    }
+
+    /**
+     * Counts the matches from a random sample of the roots, in rounds that
+     * double in size, until the estimate is within targetError, maxSamples
+     * roots have been sampled, or all of them have.  The roots are sampled
+     * in the same order every time, so estimates can be repeated.
+     * @param roots  Edges matches can start the search with.
+     * @param search  Search to copy for each thread.
+     * @param searchRoot  Counts the matches a copy of search finds from a root.
+     */
+    template<typename Search, typename SearchRoot>
+    CountEstimate sampleRoots(EdgeRange roots, const Search &search, SearchRoot searchRoot,
+        int numThreads, long maxSamples, double targetError)
+    {
+        const long FIRST_ROUND = 1024;
+        const int CHUNK_SIZE = 16;
+        vector<int> order(roots.begin(), roots.end());
+        long numRoots = order.size();
+        long sampleEnd = (maxSamples > 0) ? std::min(maxSamples, numRoots) : numRoots;
+        std::mt19937_64 random(1);
+        CountEstimate estimate(numRoots);
+        for(long begin=0, end=std::min(FIRST_ROUND, sampleEnd); begin<end; begin=end, end=std::min(2*end, sampleEnd))
+        {
+            // Pick this round's roots by shuffling them to the front
+            for(long i=begin; i<end; i++)
+                std::swap(order[i], order[std::uniform_int_distribution<long>(i, numRoots-1)(random)]);
+            
+            // Count the matches from each one, spread across the threads
+            vector<long> counts(end - begin);
+            WorkStealingPool<std::pair<long, long>> pool(numThreads);
+            for(long i=begin, chunk=0; i<end; i+=CHUNK_SIZE, chunk++)
+                pool.push(chunk % numThreads, std::make_pair(i, std::min(end, i + CHUNK_SIZE)));
+            pool.run([&](int worker)
+            {
+                Search threadSearch = search;
+                std::pair<long, long> chunk;
+                while(pool.pop(worker, chunk))
+                {
+                    for(long i=chunk.first; i<chunk.second; i++)
+                        counts[i - begin] = searchRoot(threadSearch, order[i]);
+                    pool.finish();
+                }
+            });
+            for(long count : counts)
+                estimate.add(count);
+            if(targetError > 0 && estimate.relativeError() <= targetError)
+                break;
+        }
+        return estimate;
+    }
+    
+    /** Estimates the count with the kernel for queries with NumEdges edges, if h fits it */
+    template<int NumEdges>
+    bool sampleSmall(const Graph &g, const Graph &h, const EdgeMasks &masks, int delta, const NodeDomains &domains,
+        int numThreads, long maxSamples, double targetError, CountEstimate &estimate)
+    {
+        typedef SmallQuerySearch<NumEdges, NumEdges+1> Kernel;
+        if(!Kernel::fits(h))
+            return false;
+        Kernel search(g, h, masks, delta, domains, nullptr, nullptr);
+        estimate = sampleRoots(search.roots(), search, [](Kernel &search, int g_e) { return search.searchRoot(g_e); },
+            numThreads, maxSamples, targetError);
+        return true;
+    }
+    
+    /** Estimates the count with the kernel sized for h, if there is one (returning false otherwise) */
+    bool sampleSmallQuery(const Graph &g, const Graph &h, const EdgeMasks &masks, int delta, const NodeDomains &domains,
+        int numThreads, long maxSamples, double targetError, CountEstimate &estimate)
+    {
+        switch(h.numEdges())
+        {
+        case 1: return sampleSmall<1>(g, h, masks, delta, domains, numThreads, maxSamples, targetError, estimate);
+        case 2: return sampleSmall<2>(g, h, masks, delta, domains, numThreads, maxSamples, targetError, estimate);
+        case 3: return sampleSmall<3>(g, h, masks, delta, domains, numThreads, maxSamples, targetError, estimate);
+        case 4: return sampleSmall<4>(g, h, masks, delta, domains, numThreads, maxSamples, targetError, estimate);
+        case 5: return sampleSmall<5>(g, h, masks, delta, domains, numThreads, maxSamples, targetError, estimate);
+        case 6: return sampleSmall<6>(g, h, masks, delta, domains, numThreads, maxSamples, targetError, estimate);
+        default: return false;
+        }
+    }
+
+    /** Works out the edge masks, with the criteria's class compiled in
+     * where we have one that does the same checks for less */
+    void computeEdgeMasks(const Graph &g, const Graph &h, const MatchCriteria &criteria, EdgeMasks &masks)
+    {
+        // Only the exact class, since subclasses may check other things
+        if(typeid(criteria) == typeid(MatchCriteria_DataGraph))
+        {
+            const DataGraph &dg = (const DataGraph&)g;
+            const DataGraph &dh = (const DataGraph&)h;
+            if(MatchCriteria_Labels::appliesTo(dg, dh))
+            {
+                masks.compute(g, h, MatchCriteria_Labels(dg, dh));
+                return;
+            }
+        }
+        masks.compute(g, h, criteria);
+    }
+}
+
 vector<GraphMatch> GraphSearch::findAllSubgraphs(const Graph &g, const Graph &h, int limit)
 {
     // If no criteria specified, just use the "dummy" criteria, that accepts everything.
@@ -53,21 +196,16 @@ vector<unordered_set<int>> GraphSearch::mapPossibleNodes()
 {
     vector<unordered_set<int>> possible(_h->numNodes());
     
-    int n = _g->numNodes();
+    // Edge order doesn't matter here, so only the node criteria and the
+    // neighbors can rule nodes out
+    NodeDomains domains;
+    domains.compute(*_g, *_h, *_criteria, INT_MAX, false);
+    
     // Look at each vertex in H
     for(int h_v=0; h_v<_h->numNodes(); h_v++)
     {        
-        //cout << "Testing possible nodes for " << h_v << endl;
-        // Check each vertex in G for a possible match
-        for(int g_v=0; g_v<n; g_v++)
-        {
-            //cout << "Trying " << g_v << endl;
-            // If it passes the criteria, than add it to the list of possible
-            if(_criteria->isNodeMatch(*_g, g_v, *_h, h_v))
-            {                
-                possible[h_v].insert(g_v);
-            }
-        }
+        const vector<int> &nodes = domains.nodes(h_v);
+        possible[h_v].insert(nodes.begin(), nodes.end());
     }
     return possible;
 }
@@ -122,7 +260,7 @@ bool GraphSearch::search(int &numAssigned, vector<unordered_set<int>> &h2gPossib
             int h_v = hEdge.dest();
             int g_u = _h2gNodes[h_u];
             int g_v = _h2gNodes[h_v];
-            const vector<int> &gEdges = _g->getEdgeIndexes(g_u, g_v);
+            EdgeRange gEdges = _g->getEdgeIndexes(g_u, g_v);
             for(int g_e : gEdges)
             {
                 if(_criteria->isEdgeMatch(*_g, g_e, *_h, hEdge.index()))
@@ -173,7 +311,7 @@ bool GraphSearch::matchesSoFar(int numAssigned)
             if(hasEdge)
             {
                 // Check to make sure they match the criteria
-                const vector<int> edges = _g->getEdgeIndexes(g_u,g_v);
+                EdgeRange edges = _g->getEdgeIndexes(g_u,g_v);
                 for(int e : edges)
                 {
                     if(_criteria->isEdgeMatch(*_g, e, *_h, edge.index()))
@@ -201,31 +339,226 @@ long GraphSearch::findOrderedSubgraphs(const Graph &g, const Graph &h, int limit
 }
 
 long GraphSearch::findOrderedSubgraphs(const Graph &g, const Graph &h, const MatchCriteria &criteria, int limit, int delta)
+{
+    // Only go through a sink if there's a limit to stop at
+    if(limit < INT_MAX)
+        return findOrderedSubgraphs(g, h, criteria, [](EdgeRange) { return true; }, limit, delta);
+    
+    if(_algorithm == TEMPORAL_RI)
+    {
+        TemporalRISearch search;
+        search.setNumThreads(_numThreads);
+        return search.findOrderedSubgraphs(g, h, criteria, limit, delta);
+    }
+    return searchOrdered(g, h, criteria, delta, nullptr, nullptr);
+}
+
+long GraphSearch::findOrderedSubgraphs(const Graph &g, const Graph &h, const MatchCriteria &criteria, const MatchSink &sink, int limit, int delta)
+{
+    if(_algorithm == TEMPORAL_RI)
+    {
+        TemporalRISearch search;
+        search.setNumThreads(_numThreads);
+        return search.findOrderedSubgraphs(g, h, criteria, sink, limit, delta);
+    }
+    MatchOutput output(sink, limit);
+    if(!output.stopped())
+        searchOrdered(g, h, criteria, delta, &output, nullptr);
+    return output.numMatches();
+}
+
+vector<long> GraphSearch::countOrderedSubgraphs(const Graph &g, const Graph &h, const MatchCriteria &criteria, const vector<time_t> &deltas)
+{
+    if(_algorithm == TEMPORAL_RI)
+    {
+        TemporalRISearch search;
+        search.setNumThreads(_numThreads);
+        return search.countOrderedSubgraphs(g, h, criteria, deltas);
+    }
+    DeltaCounts counts(deltas);
+    if(!deltas.empty())
+        searchOrdered(g, h, criteria, (int)std::min<time_t>(counts.maxDelta(), INT_MAX), nullptr, &counts);
+    return counts.counts();
+}
+
+CountEstimate GraphSearch::estimateOrderedSubgraphs(const Graph &g, const Graph &h, const MatchCriteria &criteria, int delta,
+    long maxSamples, double targetError)
+{
+    // Nothing can be built on demand while the threads are searching
+    if(_numThreads > 1 && (!g.frozen() || !h.frozen()))
+        throw "The graphs must be frozen to search them from multiple threads.";
+    if(!setUpOrdered(g, h, criteria, delta, nullptr, nullptr))
+        return CountEstimate();
+    
+    CountEstimate estimate;
+    if(_useSmallQueryKernels && _masks != nullptr &&
+       sampleSmallQuery(g, h, *_masks, delta, _nodeDomains, _numThreads, maxSamples, targetError, estimate))
+        return estimate;
+    
+    // Matches start with an edge that meets the first query edge's criteria
+    setUpAllEdges();
+    GraphSearch search;
+    shareSearch(search);
+    search.resetSearchState();
+    EdgeRange roots = (_masks != nullptr) ? _masks->edges(0) : _allEdges;
+    return sampleRoots(roots, search, [](GraphSearch &search, int g_e) { return search.searchRoot(g_e); },
+        _numThreads, maxSamples, targetError);
+}
+
+bool GraphSearch::setUpOrdered(const Graph &g, const Graph &h, const MatchCriteria &criteria, int delta, MatchOutput *output, DeltaCounts *deltaCounts)
 {
     // Store class data structures
     _g = &g;
     _h = &h;
     _criteria = &criteria;
     _delta = delta;
+    _output = output;
+    _deltaCounts = deltaCounts;
     
-    bool debugOutput = false;
+    // Rule out the nodes that can't be part of any match, so the search
+    // doesn't start down branches that lead nowhere
+    _nodeDomains.compute(g, h, criteria, delta);
+    _domains = &_nodeDomains;
+    if(_nodeDomains.anyEmpty())
+        return false;
     
-    // Stores the matching subgraphs as list of edge indices
-    //vector<GraphMatch> results;
+    // Test every edge against the criteria once, up front (unless we were
+    // given the results), so the search only has to check a bit
+    _masks = nullptr;
+    if(EdgeMasks::fits(h))
+    {
+        if(_givenMasks != nullptr && _givenMasks->covers(g, h))
+            _masks = _givenMasks;
+        else
+        {
+            computeEdgeMasks(g, h, criteria, _edgeMasks);
+            _masks = &_edgeMasks;
+        }
+    }
+    return true;
+}
+
+void GraphSearch::setUpAllEdges()
+{
+    int m = _g->numEdges();
+    _allEdgeIndexes.resize(m);
+    for(int i=0; i<m; i++)
+        _allEdgeIndexes[i] = i;
+    _allEdges = _allEdgeIndexes;
+}
+
+long GraphSearch::searchOrdered(const Graph &g, const Graph &h, const MatchCriteria &criteria, int delta, MatchOutput *output, DeltaCounts *deltaCounts)
+{
+    if(!setUpOrdered(g, h, criteria, delta, output, deltaCounts))
+        return 0;
+    
+    // Small queries (most of them) have search kernels of their own, which
+    // keep all of the search state in fixed-size arrays
     long numOccs = 0;
+    if(_useSmallQueryKernels && _masks != nullptr &&
+       searchSmallQuery(g, h, *_masks, delta, _nodeDomains, output, deltaCounts, _numThreads, numOccs))
+        return numOccs;
     
-    int n = _g->numNodes();
     int m = _g->numEdges();
+    setUpAllEdges();
+    resetSearchState();
+    if(_numThreads > 1)
+        return findOrderedSubgraphsParallel();
     
-    // List of all edge indexes
-    _allEdges.resize(m);
-    for(int i=0; i<m; i++)
-        _allEdges[i] = i;
+    // Search everything in one go
+    OrderedSearchTask task;
+    task.begin = 0;
+    task.end = m;
+    return searchTask(task);
+}
+
+void GraphSearch::setNumThreads(int numThreads)
+{
+    if(numThreads < 0)
+        throw "The number of search threads can't be negative.";
+    if(numThreads == 0)
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+    _numThreads = numThreads;
+}
+
+long GraphSearch::findOrderedSubgraphsParallel()
+{
+    // Nothing can be built on demand while the threads are searching
+    if(!_g->frozen() || !_h->frozen())
+        throw "The graphs must be frozen to search them from multiple threads.";
+    
+    // Split the roots into many more chunks than threads, so there are plenty
+    // to steal when some subtrees turn out bigger than others.  Neighboring
+    // chunks go to different threads, since busy periods cluster in time.
+    const int CHUNKS_PER_THREAD = 64;
+    int m = _g->numEdges();
+    int chunkSize = std::max(1, m / (_numThreads * CHUNKS_PER_THREAD));
+    WorkStealingPool<OrderedSearchTask> pool(_numThreads);
+    int chunk = 0;
+    for(int begin=0; begin<m; begin+=chunkSize, chunk++)
+    {
+        OrderedSearchTask task;
+        task.begin = begin;
+        task.end = std::min(m, begin+chunkSize);
+        pool.push(chunk % _numThreads, task);
+    }
+    
+    vector<long> threadOccs(_numThreads, 0);
+    vector<DeltaCounts> threadDeltaCounts;
+    if(_deltaCounts != nullptr)
+        threadDeltaCounts.assign(_numThreads, _deltaCounts->empty());
+    pool.run([&](int worker)
+    {
+        // Each thread gets its own search state
+        GraphSearch search;
+        shareSearch(search);
+        if(_deltaCounts != nullptr)
+            search._deltaCounts = &threadDeltaCounts[worker];
+        search._pool = &pool;
+        search._worker = worker;
+        search.resetSearchState();
+        
+        long numOccs = 0;
+        OrderedSearchTask task;
+        while(pool.pop(worker, task))
+        {
+            numOccs += search.searchTask(task);
+            pool.finish();
+            // Stop everyone once no more matches are wanted
+            if(_output != nullptr && _output->stopped())
+                pool.abort();
+        }
+        threadOccs[worker] = numOccs;
+    });
+    
+    long numOccs = 0;
+    for(long occs : threadOccs)
+        numOccs += occs;
+    for(const DeltaCounts &counts : threadDeltaCounts)
+        _deltaCounts->merge(counts);
+    return numOccs;
+}
+
+void GraphSearch::shareSearch(GraphSearch &search) const
+{
+    search._g = _g;
+    search._h = _h;
+    search._criteria = _criteria;
+    search._delta = _delta;
+    search._domains = _domains;
+    search._masks = _masks;
+    search._output = _output;
+    search._allEdges = _allEdges;
+}
+
+void GraphSearch::resetSearchState()
+{
+    int n = _g->numNodes();
     
     // Tables for mapping nodes and edges between the two graphs
     // -1 means no match has been assigned yet
     _h2gNodes.clear();
-    _h2gNodes.resize(h.numNodes(),-1);
+    _h2gNodes.resize(_h->numNodes(),-1);
     _g2hNodes.clear();
     _g2hNodes.resize(n,-1);
     
@@ -237,22 +570,238 @@ long GraphSearch::findOrderedSubgraphs(const Graph &g, const Graph &h, const Mat
             
     // Stores all edges found that match our query.
     // Stack used to backtrack when a particular search ends up a dead-end.
-    //cout << "prova" << endl;
-    while(_sg_edgeStack.empty()==false) // Make sure it's empty to start
+    _sg_edgeStack.clear();
+    _sg_edgeStack.reserve(_h->numEdges());
+    _sg_start_edgeStack.clear();
+    _levelEnds.assign(_h->numEdges(), _g->numEdges());
+    
+    // Count the steps up in time through the query edges, since each one
+    // puts at least one time unit between the matched edges
+    const time_t *hTimes = _h->edges().times().data();
+    _timeSteps.assign(_h->numEdges(), 0);
+    for(int h_i=1; h_i<_h->numEdges(); h_i++)
+        _timeSteps[h_i] = _timeSteps[h_i-1] + (hTimes[h_i] > hTimes[h_i-1] ? 1 : 0);
+}
+
+void GraphSearch::pushMatch(int h_i, int g_i, int g_i_start)
+{
+    const Edge &h_edge = _h->edges()[h_i];
+    int h_u = h_edge.source();
+    int h_v = h_edge.dest();
+    
+    // Get matched edge
+    const Edge &g_edge = _g->edges()[g_i];
+    int g_u = g_edge.source();
+    int g_v = g_edge.dest();
+
+    // Set the first edge time, if needed
+    if(_sg_edgeStack.empty())
+        _firstEdgeTime = g_edge.time();
+    
+    // Map the nodes from each graph
+    _h2gNodes[h_u] = g_u;
+    _h2gNodes[h_v] = g_v;
+    _g2hNodes[g_u] = h_u;
+    _g2hNodes[g_v] = h_v;            
+
+    // Increment number of search edges for each node in our G edge
+    _numSearchEdgesForNode[g_u]++;
+    _numSearchEdgesForNode[g_v]++; 
+    
+    // Add it to the stack
+    _sg_edgeStack.push_back(g_i);
+    _sg_start_edgeStack.push_back(g_i_start);
+}
+
+void GraphSearch::popMatch()
+{
+    int last_g_i = _sg_edgeStack.back();
+    _sg_edgeStack.pop_back();
+    _sg_start_edgeStack.pop_back();
+    
+    // Get edge object
+    const Edge &g_edge = _g->edges()[last_g_i];            
+
+    // Decrement the number of edges for the nodes in g_i
+    _numSearchEdgesForNode[g_edge.source()]--;
+    _numSearchEdgesForNode[g_edge.dest()]--;
+
+    // If any of them reach zero, then we need to remove the
+    // node mapping for that node, since none of our edges are
+    // currently using it (making it free to be re-assigned).
+    if(_numSearchEdgesForNode[g_edge.source()]==0)
     {
-        _sg_edgeStack.pop();
-        _sg_start_edgeStack.pop();
-        //_h_edgeStack.pop();
+        int old_h_u = _g2hNodes[g_edge.source()];
+        _h2gNodes[old_h_u] = -1;
+        _g2hNodes[g_edge.source()] = -1;
     }
+    if(_numSearchEdgesForNode[g_edge.dest()]==0)
+    {
+        int old_h_v = _g2hNodes[g_edge.dest()];
+        _h2gNodes[old_h_v] = -1;
+        _g2hNodes[g_edge.dest()] = -1;
+    }
+}
+
+bool GraphSearch::canFinish(int h_i)
+{
+    // Without edge masks, it'd cost as much to check as to search
+    if(_masks == nullptr)
+        return true;
+    
+    const EdgeList &gEdges = _g->edges();
+    const int *sources = gEdges.sources().data();
+    const int *dests = gEdges.dests().data();
+    const EdgeList &hEdges = _h->edges();
+    int k = _h->numEdges();
+    time_t curTime = gEdges.times()[_sg_edgeStack.back()];
+    time_t endTime = _firstEdgeTime + _delta;
+    
+    // The next query edge is searched for straight away, so start after it
+    for(int h_j=h_i+2; h_j<k; h_j++)
+    {
+        // Work out when it could happen: after the match of h_i by at least
+        // a time unit per step up in the query (or at the same time if there
+        // are none), with room left for the steps after it within delta
+        int steps = _timeSteps[h_j] - _timeSteps[h_i];
+        time_t minTime = curTime + steps;
+        time_t maxTime = (steps == 0) ? curTime : endTime - (_timeSteps[k-1] - _timeSteps[h_j]);
+        if(minTime > maxTime)
+            return false;
         
+        // Look in the edges of its matched ends, or the edges that meet its
+        // criteria if neither end is matched
+        int g_u = _h2gNodes[hEdges.sources()[h_j]];
+        int g_v = _h2gNodes[hEdges.dests()[h_j]];
+        EdgeRange edges = _masks->edges(h_j);
+        const time_t *times = _masks->times(h_j).data();
+        if(g_u >= 0 && (g_v < 0 || _g->nodes()[g_u].outEdges().size() <= _g->nodes()[g_v].inEdges().size()))
+        {
+            edges = _g->nodes()[g_u].outEdges();
+            times = _g->nodes()[g_u].outEdgeTimes().data();
+        }
+        else if(g_v >= 0)
+        {
+            edges = _g->nodes()[g_v].inEdges();
+            times = _g->nodes()[g_v].inEdgeTimes().data();
+        }
+        
+        // Look at the first few edges in the time range for one that could
+        // match.  If none of those do, assume one of the rest might, so the
+        // check stays cheap.
+        const int MAX_LOOKS = 8;
+        const time_t *first = std::lower_bound(times, times + edges.size(), minTime);
+        const time_t *last = times + edges.size();
+        bool found = false;
+        for(int looks=0; first != last && *first <= maxTime && !found; ++first, looks++)
+        {
+            int g_e = edges[first - times];
+            found = looks == MAX_LOOKS || (_masks->matches(g_e, h_j) &&
+                (g_u < 0 || sources[g_e] == g_u) && (g_v < 0 || dests[g_e] == g_v));
+        }
+        if(!found)
+            return false;
+    }
+    return true;
+}
+
+bool GraphSearch::reportMatch(int g_i)
+{
+    // The stack has room for the last edge, so there's nothing to allocate
+    _sg_edgeStack.push_back(g_i);
+    bool more = _output->report(_sg_edgeStack);
+    _sg_edgeStack.pop_back();
+    return more;
+}
+
+long GraphSearch::searchRoot(int g_e)
+{
+    OrderedSearchTask task;
+    task.begin = g_e;
+    task.end = g_e + 1;
+    return searchTask(task);
+}
+
+long GraphSearch::searchTask(const OrderedSearchTask &task)
+{
+    int depth = task.prefix.size();
+    if(task.begin >= std::min(task.end, _g->numEdges()))
+        return 0;
+    
+    // Put the search state back the way it was when the task was split off
+    for(int h_i=0; h_i<depth; h_i++)
+        pushMatch(h_i, task.prefix[h_i], task.prefixStarts[h_i]);
+    _levelEnds[depth] = task.end;
+    
+    long numOccs = searchFrom(depth, task.begin);
+    
+    // Leave the search state clear for the next task
+    while(_sg_edgeStack.empty()==false)
+        popMatch();
+    return numOccs;
+}
+
+void GraphSearch::donateWork(int depth)
+{
+    // Wait until our last donation has been taken
+    if(_pool->size(_worker) > 0)
+        return;
+    
+    // Edges past our delta can't be matched by anything after the first edge
+    const time_t *times = _g->edges().times().data();
+    int m = _g->numEdges();
+    int deltaEnd = m;
+    if(_sg_edgeStack.empty()==false)
+        deltaEnd = std::upper_bound(times, times + m, _firstEdgeTime + _delta) - times;
+    
+    // Give away the second half of the untried edges at the shallowest level
+    // we can, since it's likely to have the biggest subtrees left
+    const int MIN_DONATION = 2;
+    for(int level=depth; level<_sg_edgeStack.size(); level++)
+    {
+        int begin = _sg_edgeStack[level] + 1;
+        int end = _levelEnds[level];
+        int usefulEnd = level == 0 ? end : std::min(end, deltaEnd);
+        if(usefulEnd - begin < MIN_DONATION)
+            continue;
+        int split = begin + (usefulEnd - begin)/2;
+        
+        OrderedSearchTask task;
+        task.prefix.assign(_sg_edgeStack.begin(), _sg_edgeStack.begin() + level);
+        task.prefixStarts.assign(_sg_start_edgeStack.begin(), _sg_start_edgeStack.begin() + level);
+        task.begin = split;
+        task.end = end;
+        _levelEnds[level] = split;
+        _pool->push(_worker, task);
+        return;
+    }
+}
+
+long GraphSearch::searchFrom(int depth, int g_i)
+{
+    bool debugOutput = false;
+    
+    // Stores the matching subgraphs as list of edge indices
+    //vector<GraphMatch> results;
+    long numOccs = 0;
+    
+    const Graph &g = *_g;
+    int m = _g->numEdges();
+    int delta = _delta;
+    
     // The edge from H we are trying to match in G
-    int h_i = 0;
-    // The current edge from G we are testing out (yes, should start at -1)
-    int g_i = 0;
-    int g_i_start = 0;
+    int h_i = depth;
+    // First edge with the same time as g_i, for matching query edges that
+    // happen at the same time
+    const time_t *times = g.edges().times().data();
+    int g_i_start = std::lower_bound(times, times + g_i, times[g_i]) - times;
     
     time_t prevTimeQuery=0;
     time_t prevTimeTarget=0;
+    if(h_i > 0)
+        prevTimeQuery = _h->edges()[h_i-1].time();
+    if(_sg_edgeStack.empty()==false)
+        prevTimeTarget = g.edges()[_sg_edgeStack.back()].time();
     time_t curEdgeTime = 0;
     curEdgeTime = g.edges()[g_i].time();
     
@@ -262,53 +811,32 @@ long GraphSearch::findOrderedSubgraphs(const Graph &g, const Graph &h, const Mat
         
         while(g_i >= m || (_sg_edgeStack.empty()==false && curEdgeTime - _firstEdgeTime > delta))
         {             
-            // If the edge stack is empty, then we have no options left
-            // and need to give up.
-            if(_sg_edgeStack.empty())            
+            // If we're back to the edges we started with, then we have no
+            // options left and need to give up.
+            if(_sg_edgeStack.size() == depth)
                 //return results;
                 return numOccs;
                     
             // Pop the stack
-            int last_g_i = _sg_edgeStack.top();            
-            _sg_edgeStack.pop();
-            int last_g_i_start = _sg_start_edgeStack.top();            
-            _sg_start_edgeStack.pop();
+            int last_g_i = _sg_edgeStack.back();            
+            int last_g_i_start = _sg_start_edgeStack.back();            
+            if(debugOutput)
+            {
+                const Edge &g_edge = _g->edges()[last_g_i];            
+                cout << "Giving up on edge " << last_g_i << ": " << g_edge.source() << ", " << g_edge.dest() << endl;
+            }
+            popMatch();
             
             if(_sg_edgeStack.empty()==true)
                 prevTimeTarget=0;
             else
             {
-                int prev_g_i = _sg_edgeStack.top();
+                int prev_g_i = _sg_edgeStack.back();
                 const Edge &g_edge = _g->edges()[prev_g_i];
                 prevTimeTarget=g_edge.time();
                 
             }
 
-            // Get edge object
-            const Edge &g_edge = _g->edges()[last_g_i];            
-            if(debugOutput)
-                cout << "Giving up on edge " << last_g_i << ": " << g_edge.source() << ", " << g_edge.dest() << endl;
-
-            // Decrement the number of edges for the nodes in g_i
-            _numSearchEdgesForNode[g_edge.source()]--;
-            _numSearchEdgesForNode[g_edge.dest()]--;
-
-            // If any of them reach zero, then we need to remove the
-            // node mapping for that node, since none of our edges are
-            // currently using it (making it free to be re-assigned).
-            if(_numSearchEdgesForNode[g_edge.source()]==0)
-            {
-                int old_h_u = _g2hNodes[g_edge.source()];
-                _h2gNodes[old_h_u] = -1;
-                _g2hNodes[g_edge.source()] = -1;
-            }
-            if(_numSearchEdgesForNode[g_edge.dest()]==0)
-            {
-                int old_h_v = _g2hNodes[g_edge.dest()];
-                _h2gNodes[old_h_v] = -1;
-                _g2hNodes[g_edge.dest()] = -1;
-            }
-
             // Decrement h_i, so that we can find a new one
             h_i--;
             if(h_i==0)
@@ -330,13 +858,20 @@ long GraphSearch::findOrderedSubgraphs(const Graph &g, const Graph &h, const Mat
             
         }       
         
-        // Get query edge
-        const Edge &h_edge = _h->edges()[h_i];
-        int h_u = h_edge.source();
-        int h_v = h_edge.dest();
-                
+        // Stop if another thread has found all the matches we want
+        if(_output != nullptr && _output->stopped())
+            return numOccs;
+        
+        // If other threads are out of work, give them some of ours
+        if(_pool != nullptr && _pool->hungry())
+            donateWork(depth);
+        
         // Find matching edge, if possible
         g_i = this->findNextMatch(h_i, g_i, prevTimeQuery, prevTimeTarget);
+        
+        // Edges past the end of this level's range are someone else's
+        if(g_i >= _levelEnds[h_i])
+            g_i = m;
 		
         if(g_i < m)
         {            
@@ -356,6 +891,10 @@ long GraphSearch::findOrderedSubgraphs(const Graph &g, const Graph &h, const Mat
                 // Add new subgraph to the results
                 //results.push_back(match);
                 numOccs++;
+                if(_deltaCounts != nullptr)
+                    _deltaCounts->add(_sg_edgeStack.empty() ? 0 : times[g_i] - _firstEdgeTime);
+                if(_output != nullptr && !reportMatch(g_i))
+                    return numOccs;
                 
                 g_i++;
                 if(g_i<m)
@@ -377,33 +916,31 @@ long GraphSearch::findOrderedSubgraphs(const Graph &g, const Graph &h, const Mat
             // and continue on to find next edges.
             else
             {  
-                // Get matched edge
-                const Edge &g_edge = _g->edges()[g_i];
-                int g_u = g_edge.source();
-                int g_v = g_edge.dest();
-
-                // Set the first edge time, if needed
-                if(_sg_edgeStack.empty())
-                    _firstEdgeTime = g_edge.time();
+                pushMatch(h_i, g_i, g_i_start);
                 
-                // Map the nodes from each graph
-                _h2gNodes[h_u] = g_u;
-                _h2gNodes[h_v] = g_v;
-                _g2hNodes[g_u] = h_u;
-                _g2hNodes[g_v] = h_v;            
-
-                // Increment number of search edges for each node in our G edge
-                _numSearchEdgesForNode[g_u]++;
-                _numSearchEdgesForNode[g_v]++; 
+                // If the rest of the query can't be matched from here, move
+                // on to the next edge without searching below this one
+                if(!canFinish(h_i))
+                {
+                    popMatch();
+                    g_i++;
+                    if(g_i<m)
+                    {
+                        curEdgeTime = g.edges()[g_i-1].time();
+                        time_t newCurEdgeTime = g.edges()[g_i].time();
+                        if(newCurEdgeTime!=curEdgeTime)
+                            g_i_start=g_i;
+                    }
+                    continue;
+                }
                 
-                // Add it to the stack
-                _sg_edgeStack.push(g_i);
-                _sg_start_edgeStack.push(g_i_start);
-                prevTimeTarget=g_edge.time();
+                prevTimeTarget=g.edges()[g_i].time();
                 //_h_edgeStack.push(h_i);
                                 
-                // Increment to next edge to find
+                // Increment to next edge to find, which can use any edge
+                // until someone takes part of it
                 h_i++;
+                _levelEnds[h_i] = m;
                 const Edge &h_edge = _h->edges()[h_i-1];
                 prevTimeQuery=h_edge.time();
                 
@@ -446,35 +983,58 @@ int GraphSearch::findNextMatch(int h_i, int g_i, time_t prevTimeQuery, time_t pr
     const Edge &h_edge = _h->edges()[h_i];
     int h_u = h_edge.source();
     int h_v = h_edge.dest();
+    time_t currTimeQuery = h_edge.time();
         
-    // Default is to search over all edges starting at g_i
-    const vector<int> *searchEdges = &_allEdges;
+    // Default is to search over all edges starting at g_i (or just the
+    // ones that meet the criteria, if we know them)
+    EdgeRange searchEdges = _allEdges;
+    const time_t *searchTimes = _g->edges().times().data();
+    CandidateScan::ListType list = CandidateScan::MATCHING_EDGES;
+    if(_masks != nullptr)
+    {
+        searchEdges = _masks->edges(h_i);
+        searchTimes = _masks->times(h_i).data();
+    }
         
     // Look to see if nodes are already mapped, and just use those
     // node edges, if so. (Much faster!)
     if(_h2gNodes[h_u] >= 0 && _h2gNodes[h_v] >= 0)
     {
-        const vector<int> &uEdges = _g->nodes()[_h2gNodes[h_u]].outEdges();
-        const vector<int> &vEdges = _g->nodes()[_h2gNodes[h_v]].inEdges();
-        if(uEdges.size() < vEdges.size())
-            searchEdges = &uEdges;
+        const Node &uNode = _g->nodes()[_h2gNodes[h_u]];
+        const Node &vNode = _g->nodes()[_h2gNodes[h_v]];
+        if(uNode.outEdges().size() < vNode.inEdges().size())
+        {
+            searchEdges = uNode.outEdges();
+            searchTimes = uNode.outEdgeTimes().data();
+            list = CandidateScan::SOURCE_EDGES;
+        }
         else
-            searchEdges = &vEdges;
+        {
+            searchEdges = vNode.inEdges();
+            searchTimes = vNode.inEdgeTimes().data();
+            list = CandidateScan::DEST_EDGES;
+        }
     }
     else if(_h2gNodes[h_u] >= 0)
     {
-        searchEdges = &_g->nodes()[_h2gNodes[h_u]].outEdges();
+        const Node &uNode = _g->nodes()[_h2gNodes[h_u]];
+        searchEdges = uNode.outEdges();
+        searchTimes = uNode.outEdgeTimes().data();
+        list = CandidateScan::SOURCE_EDGES;
     }
     else if(_h2gNodes[h_v] >= 0)
     {
-        searchEdges = &_g->nodes()[_h2gNodes[h_v]].inEdges();
+        const Node &vNode = _g->nodes()[_h2gNodes[h_v]];
+        searchEdges = vNode.inEdges();
+        searchTimes = vNode.inEdgeTimes().data();
+        list = CandidateScan::DEST_EDGES;
     }
     
     // Find starting place in the list
-    int start = findStart(g_i, *searchEdges);
+    int start = findStart(g_i, searchEdges);
     
     // If no starting place can be found, just return that it's not possible
-    if(start == searchEdges->size())
+    if(start == searchEdges.size())
         return _g->numEdges();
     /*if(debugOutput)
     {
@@ -482,11 +1042,41 @@ int GraphSearch::findNextMatch(int h_i, int g_i, time_t prevTimeQuery, time_t pr
         cout << "Found this one: " << 
     }*/
     
+    // Work out which times the matching edge can have.  If the query edge
+    // happens at the same time as the previous one, so must the matched edge.
+    // Otherwise it has to come after the previous matched edge.  It also
+    // can't go past our delta.  The first edge can have any time.
+    time_t minTime, maxTime;
+    if(_sg_edgeStack.empty())
+    {
+        minTime = std::numeric_limits<time_t>::min();
+        maxTime = std::numeric_limits<time_t>::max();
+    }
+    else if(currTimeQuery == prevTimeQuery)
+    {
+        minTime = prevTimeTarget;
+        maxTime = prevTimeTarget;
+    }
+    else if(currTimeQuery > prevTimeQuery)
+    {
+        minTime = prevTimeTarget + 1;
+        maxTime = std::numeric_limits<time_t>::max();
+    }
+    else
+        return _g->numEdges();
+    if(_sg_edgeStack.empty()==false)
+        maxTime = std::min(maxTime, _firstEdgeTime + _delta);
+    
+    // The list is in chronological order, so we can jump straight to the
+    // edges in that time range
+    const time_t *first = std::lower_bound(searchTimes + start, searchTimes + searchEdges.size(), minTime);
+    const time_t *last = std::upper_bound(first, searchTimes + searchEdges.size(), maxTime);
+    
     // Perform search
-    return findNextMatch(h_i, *searchEdges, start, prevTimeQuery, prevTimeTarget);
+    return findNextMatch(h_i, searchEdges, list, first - searchTimes, last - searchTimes);
 }
 
-int GraphSearch::findStart(int g_i, const std::vector<int> &edgeIndexes)
+int GraphSearch::findStart(int g_i, EdgeRange edgeIndexes)
 {
     // If it's the original edges, just return g_i
     if(edgeIndexes.size() > g_i && edgeIndexes[g_i] == g_i)
@@ -539,7 +1129,7 @@ int GraphSearch::findStart(int g_i, const std::vector<int> &edgeIndexes)
     }
 }
 
-int GraphSearch::findNextMatch(int h_i, const std::vector<int> &edgesToSearch, int startIndex, time_t prevTimeQuery, time_t prevTimeTarget)
+int GraphSearch::findNextMatch(int h_i, EdgeRange edgesToSearch, CandidateScan::ListType list, int startIndex, int endIndex)
 {
     bool debugOutput = false;
     
@@ -547,26 +1137,50 @@ int GraphSearch::findNextMatch(int h_i, const std::vector<int> &edgesToSearch, i
     const Edge &h_edge = _h->edges()[h_i];
     int h_u = h_edge.source();
     int h_v = h_edge.dest();
-    time_t currTimeQuery = h_edge.time();
-
-    // Check the time against the previous matched edge, if any exist
-    bool checkTime = _sg_edgeStack.empty()==false;
     
-    // Loop over all the edges to search
-    for(int i=startIndex; i<edgesToSearch.size(); i++)
+    // Read the edges of G straight from their columns
+    const EdgeList &gEdges = _g->edges();
+    const int *sources = gEdges.sources().data();
+    const int *dests = gEdges.dests().data();
+    
+    // With edge masks, filter the edges a block at a time on the simple
+    // checks, and only look closer at the ones that pass.  (We only want
+    // the first match, so the blocks start small, and grow while nothing
+    // passes.)
+    if(_masks != nullptr)
+    {
+        CandidateScan scan(*_g, *_masks, h_i, h_u == h_v, _h2gNodes[h_u], _h2gNodes[h_v], list);
+        int passed[CandidateScan::BLOCK_SIZE];
+        const int *edges = edgesToSearch.begin();
+        int blockSize = 16;
+        for(int i=startIndex; i<endIndex; i+=blockSize, blockSize=std::min(2*blockSize, int(CandidateScan::BLOCK_SIZE)))
+        {
+            int numPassed = scan.filter(edges + i, edges + std::min(endIndex, i + blockSize), passed);
+            for(int j=0; j<numPassed; j++)
+            {
+                // New ends must be unmatched, and in their domains
+                int g_i = passed[j];
+                int g_u = sources[g_i];
+                int g_v = dests[g_i];
+                if(_h2gNodes[h_u] < 0 && (_g2hNodes[g_u] >= 0 || !_domains->contains(h_u, g_u)))
+                    continue;
+                if(_h2gNodes[h_v] < 0 && (_g2hNodes[g_v] >= 0 || !_domains->contains(h_v, g_v)))
+                    continue;
+                return g_i;
+            }
+        }
+        return _g->numEdges();
+    }
+    
+    // Loop over the edges to search (which are all within our time range)
+    for(int i=startIndex; i<endIndex; i++)
     {
         // Get the index of our edge in G
         int g_i = edgesToSearch[i];
         
         // Get original edge
-        const Edge &g_edge = _g->edges()[g_i];
-        int g_u = g_edge.source();
-        int g_v = g_edge.dest();
-        time_t currTimeTarget = g_edge.time();
-
-	// If we've gone past our delta, stop the search
-	if(checkTime && g_edge.time() - _firstEdgeTime > _delta)
-	    return _g->numEdges();
+        int g_u = sources[g_i];
+        int g_v = dests[g_i];
         
         if(debugOutput)
         {
@@ -579,17 +1193,14 @@ int GraphSearch::findNextMatch(int h_i, const std::vector<int> &edgesToSearch, i
 	// Make sure if the edge is a self-loop or not
 	if((h_u == h_v && g_u == g_v) || (h_u != h_v && g_u != g_v))
 	{
-	    // Test if source nodes match, or both are unassigned
-	    if(_h2gNodes[h_u] == g_u || (_h2gNodes[h_u] < 0 && _g2hNodes[g_u] < 0))
+	    // Test if source nodes match, or both are unassigned (and g_u can be matched to h_u)
+	    if(_h2gNodes[h_u] == g_u || (_h2gNodes[h_u] < 0 && _g2hNodes[g_u] < 0 && _domains->contains(h_u, g_u)))
 	    {              
 		// Test if destination nodes match, or both are unassigned
-		if(_h2gNodes[h_v] == g_v || (_h2gNodes[h_v] < 0 && _g2hNodes[g_v] < 0))
+		if(_h2gNodes[h_v] == g_v || (_h2gNodes[h_v] < 0 && _g2hNodes[g_v] < 0 && _domains->contains(h_v, g_v)))
 		{
 		    // Test if metadata criteria is a match
-		    if(_criteria->isEdgeMatch(*_g,g_i,*_h,h_i) && 
-                ((currTimeQuery>prevTimeQuery && currTimeTarget>prevTimeTarget) 
-            || (currTimeQuery==prevTimeQuery && currTimeTarget==prevTimeTarget))
-            )
+		    if(_masks != nullptr ? _masks->matches(g_i,h_i) : _criteria->isEdgeMatch(*_g,g_i,*_h,h_i))
 		    {   
 			if(debugOutput)
 			    cout << "Edge " << g_i << ": " << g_u << ", " << g_v << " is a match" << endl;
@@ -8,20 +8,37 @@
 #ifndef GRAPHSEARCH_H
 #define	GRAPHSEARCH_H
 
+#include "CandidateScan.h"
+#include "CountEstimate.h"
+#include "DeltaCounts.h"
+#include "EdgeMasks.h"
 #include "Graph.h"
 #include "MatchCriteria.h"
+#include "MatchOutput.h"
+#include "NodeDomains.h"
 #include <limits.h>
 #include <vector>
 #include <stack>
 #include <unordered_set>
 #include "GraphMatch.h"
 
+template<typename Task> class WorkStealingPool;
+
 /**
  * Main class for performing subgraph searches.
  */
 class GraphSearch
 {
 public:  
+    /** Algorithms findOrderedSubgraphs can use */
+    enum Algorithm
+    {
+        // Match the query edges in time order
+        TIME_ORDER,
+        // Match the query edges in TemporalRI's order (see TemporalRISearch)
+        TEMPORAL_RI
+    };
+    
     /** 
      * Performs a subgraph search, in which the ORDER of the edges between the
      * query graph and original graph must match.  If a -> b comes before b -> c
@@ -33,7 +50,7 @@ public:
      * @param h  The directed query graph we are trying to match.
      * @param limit  The max number of subgraphs to find.
      * @param delta  The max time duration allowed between edge matches.
-     * @return  List of subgraphs that match h.
+     * @return  Number of subgraphs that match h (up to limit).
      */
     long findOrderedSubgraphs(const Graph &g, const Graph &h, int limit = INT_MAX, int delta = INT_MAX);
     
@@ -49,10 +66,58 @@ public:
      * @param criteria  Polymorphic class specifies whether or not two given edges match the query criteria.
      * @param limit  The max number of subgraphs to find.
      * @param delta  The max time duration allowed between edge matches.
-     * @return  List of subgraphs that match h.
+     * @return  Number of subgraphs that match h (up to limit).
      */
     long findOrderedSubgraphs(const Graph &g, const Graph &h, const MatchCriteria &criteria, int limit = INT_MAX, int delta = INT_MAX);
     
+    /** 
+     * Performs the same search as findOrderedSubgraphs above, but gives each
+     * matching subgraph to a sink as soon as it's found, so the search can
+     * stop early (say, once any match is found).
+     * @param g  The directed graph to search on.
+     * @param h  The directed query graph we are trying to match.
+     * @param criteria  Polymorphic class specifies whether or not two given edges match the query criteria.
+     * @param sink  Receives the edges in g matched to each edge of h, and
+     * returns false to stop the search.  With more than one thread, it's
+     * called from all of them, but only one at a time.
+     * @param limit  The max number of subgraphs to give to the sink.
+     * @param delta  The max time duration allowed between edge matches.
+     * @return  Number of subgraphs given to the sink.
+     */
+    long findOrderedSubgraphs(const Graph &g, const Graph &h, const MatchCriteria &criteria, const MatchSink &sink, int limit = INT_MAX, int delta = INT_MAX);
+    
+    /**
+     * Counts the subgraphs that match h (the same as findOrderedSubgraphs)
+     * for several delta values, with a single search using the largest one.
+     * Each match is counted for every delta at least as long as its span.
+     * @param g  The directed graph to search on.
+     * @param h  The directed query graph we are trying to match.
+     * @param criteria  Polymorphic class specifies whether or not two given edges match the query criteria.
+     * @param deltas  The max time durations allowed between edge matches.
+     * @return  Number of subgraphs that match h within each delta.
+     */
+    std::vector<long> countOrderedSubgraphs(const Graph &g, const Graph &h, const MatchCriteria &criteria, const std::vector<time_t> &deltas);
+    
+    /**
+     * Estimates the number of subgraphs that match h (the same count as
+     * findOrderedSubgraphs, with the TIME_ORDER algorithm), without searching
+     * all of g.  It picks a random sample of the edges matches start with,
+     * and counts the matches from each of them exactly (see CountEstimate).
+     * The sample grows in rounds, each twice the size of the last, until the
+     * estimate is close enough or the sample is as big as allowed.  Sampling
+     * every edge gives the exact count.
+     * @param g  The directed graph to search on.
+     * @param h  The directed query graph we are trying to match.
+     * @param criteria  Polymorphic class specifies whether or not two given edges match the query criteria.
+     * @param delta  The max time duration allowed between edge matches.
+     * @param maxSamples  The max number of edges to sample (0 for no limit).
+     * @param targetError  Stops once the 95% confidence margin is within this
+     * fraction of the estimate (0 to stop only at maxSamples).
+     * @return  The estimate, with its margin.
+     */
+    CountEstimate estimateOrderedSubgraphs(const Graph &g, const Graph &h, const MatchCriteria &criteria, int delta,
+        long maxSamples, double targetError);
+    
     /** 
      * Performs a subgraph search, in which the edge order does NOT matter,
      * and date/time of events is usually ignored.
@@ -78,9 +143,114 @@ public:
      */
     std::vector<GraphMatch> findAllSubgraphs(const Graph &g, const Graph &h, const MatchCriteria &criteria, int limit = INT_MAX);
     
+    /**
+     * Sets how many threads findOrderedSubgraphs uses.  With more than one,
+     * the graphs must be frozen, since they're searched from every thread.
+     * @param numThreads  Number of threads (0 for one per core).
+     */
+    void setNumThreads(int numThreads);
+    /** Number of threads findOrderedSubgraphs uses */
+    int numThreads() const { return _numThreads; }
+    
+    /** Sets the algorithm findOrderedSubgraphs uses (TIME_ORDER by default) */
+    void setAlgorithm(Algorithm algorithm) { _algorithm = algorithm; }
+    Algorithm algorithm() const { return _algorithm; }
+    
+    /**
+     * Gives findOrderedSubgraphs the criteria results for the graphs it'll
+     * search (such as from GraphFilter::filter), so it doesn't work them
+     * out again.  They're only used for graphs they cover.
+     * @param masks  Edge masks, which must outlive the searches (or null to work them out).
+     */
+    void setEdgeMasks(const EdgeMasks *masks) { _givenMasks = masks; }
+    
+    /** Sets whether TIME_ORDER searches of small queries (up to 6 edges) use
+     * the fixed-size SmallQuerySearch kernels (true by default) */
+    void setSmallQueryKernels(bool use) { _useSmallQueryKernels = use; }
+    bool smallQueryKernels() const { return _useSmallQueryKernels; }
+    
 private:
     
-    /** Creates map of which nodes in G can map to the nodes we are searching for from H */
+    /**
+     * Part of an ordered search, which can be searched on any thread.  It's
+     * every match that starts with the prefix edges, and matches the next
+     * query edge to an edge in G from begin up to end.
+     */
+    struct OrderedSearchTask
+    {
+        // Edges in G matched to the first query edges, and their g_i_start values
+        std::vector<int> prefix, prefixStarts;
+        // Range of edges in G to match the next query edge to
+        int begin, end;
+    };
+    
+    /**
+     * Performs the ordered search with the time order algorithm.
+     * @param output  Where to give the matches, or null to just count them.
+     * @param deltaCounts  Where to count the matches by their time span, or null.
+     * @return  The number of matching subgraphs found.
+     */
+    long searchOrdered(const Graph &g, const Graph &h, const MatchCriteria &criteria, int delta, MatchOutput *output, DeltaCounts *deltaCounts);
+    
+    /** 
+     * Performs the ordered search for a task, using this object's search
+     * state, which must be clear (as it is after resetSearchState(), and
+     * after each call).
+     * @return  The number of matching subgraphs found.
+     */
+    long searchTask(const OrderedSearchTask &task);
+    
+    /** Counts the matches whose first edge is g_e, from a clear search state */
+    long searchRoot(int g_e);
+    
+    /**
+     * Performs the ordered search from the current search state, where the
+     * first depth query edges are already matched, and the next one is
+     * matched to edges in G from g_i up to the end of its level's range.
+     * @return  The number of matching subgraphs found.
+     */
+    long searchFrom(int depth, int g_i);
+    
+    /** Splits up the ordered search by the first edge matched, and searches
+     * the pieces on multiple threads (each with its own search state). */
+    long findOrderedSubgraphsParallel();
+    
+    /** Gives part of the remaining search (below the given depth) to the
+     * pool, for a thread that's run out of work */
+    void donateWork(int depth);
+    
+    /** Stores the graphs and settings for an ordered search, and works out the
+     * node domains and edge masks.  Returns false if nothing can match. */
+    bool setUpOrdered(const Graph &g, const Graph &h, const MatchCriteria &criteria, int delta, MatchOutput *output, DeltaCounts *deltaCounts);
+    
+    /** Lists every edge of G, for searches that can't narrow them down */
+    void setUpAllEdges();
+    
+    /** Gives another search our graphs, settings and shared tables, so it can
+     * do part of our search (on another thread) */
+    void shareSearch(GraphSearch &search) const;
+    
+    /** Clears the node mappings and the edge stack, sizing them for the current graphs */
+    void resetSearchState();
+    
+    /** Adds the match of query edge h_i to edge g_i to the edge stack, and maps their nodes */
+    void pushMatch(int h_i, int g_i, int g_i_start);
+    
+    /** Removes the last match from the edge stack, and unmaps any nodes no longer used */
+    void popMatch();
+    
+    /** Checks, cheaply, that every query edge past the one after h_i (which
+     * was just matched) still has an edge in G that could match it: one that meets
+     * its criteria, joins any nodes its ends are matched to, and happens in
+     * the time left for it.  Returns false if the search can't finish from here. */
+    bool canFinish(int h_i);
+    
+    /** Gives the match of the edge stack and the last edge g_i to the output.
+     * Returns false if the search should stop. */
+    bool reportMatch(int g_i);
+    
+    /** Creates map of which nodes in G can map to the nodes we are searching for from H
+     * (the nodes that pass the criteria and have enough neighbors, see NodeDomains) */
     std::vector<std::unordered_set<int>> mapPossibleNodes();
     
     /** Performs recursive unordered graph search, stopping at first matching subgraph */
@@ -92,15 +262,19 @@ private:
     /** Returns true if the number assigned all match up with the appropriate edges */
     bool matchesSoFar(int numAssigned);
     
-    /** Picks an efficient list of edge indexes to search from before searching through them
-     * for a edge that matches query edge h_i. The return value is the index of
-     * the matching edge in G.  If no edge is found, it will return the size of edges in G. */
+    /** Picks an efficient list of edge indexes to search from, and uses the edge times of that
+     * list to narrow it down to the edges that could follow the previous match (in time, and
+     * within delta) before searching through them for a edge that matches query edge h_i.
+     * The return value is the index of the matching edge in G.  If no edge is found,
+     * it will return the size of edges in G. */
     int findNextMatch(int h_i, int startIndex, time_t prevTimeQuery, time_t prevTimeTarget);
     
-    /** Searches through edge indexes listed in edgesToSearch (starting at the startIndex)
-     * for a edge that matches query edge h_i. The return value is the index of
-     * the matching edge in G.  If no edge is found, it will return the size of edges in G. */
-    int findNextMatch(int h_i, const std::vector<int> &edgesToSearch, int startIndex, time_t prevTimeQuery, time_t prevTimeTarget);
+    /** Searches through edge indexes listed in edgesToSearch (from startIndex up to endIndex)
+     * for a edge that matches query edge h_i.  The edges in that range must already satisfy
+     * the time restrictions, and list says what kind of list it is.  The return value is
+     * the index of the matching edge in G.  If no edge is found, it will return the size
+     * of edges in G. */
+    int findNextMatch(int h_i, EdgeRange edgesToSearch, CandidateScan::ListType list, int startIndex, int endIndex);
     
     /**
      * Performs binary search to find best starting place.
@@ -108,7 +282,7 @@ private:
      * @param edgeIndexes  List to search through.
      * @return   Index into the list where there is an edge >= g_i.
      */
-    int findStart(int g_i, const std::vector<int> &edgeIndexes);
+    int findStart(int g_i, EdgeRange edgeIndexes);
     
     /** Converts the given stack into a vector, without modifying it */
     std::vector<int> convert(std::stack<int> s);
@@ -121,12 +295,35 @@ private:
     const Graph *_g, *_h;
     const MatchCriteria *_criteria;
     int _delta;
+    // Nodes in G each query node can be matched to (shared by all the threads)
+    NodeDomains _nodeDomains;
+    const NodeDomains *_domains = nullptr;
+    // Query edges each edge of G meets the criteria of (shared by all the
+    // threads), if the query isn't too big for them, and any we were given
+    EdgeMasks _edgeMasks;
+    const EdgeMasks *_masks = nullptr, *_givenMasks = nullptr;
     time_t _firstEdgeTime;
     std::vector<int> _h2gNodes, _g2hNodes;
     std::vector<int> _numSearchEdgesForNode;
-    std::stack<int> _sg_edgeStack; //, _h_edgeStack;
-    std::stack<int> _sg_start_edgeStack;
-    std::vector<int> _allEdges;
+    std::vector<int> _sg_edgeStack; //, _h_edgeStack;
+    std::vector<int> _sg_start_edgeStack;
+    // Matches for query edge h_i must come before edge _levelEnds[h_i] in G
+    // (the rest of the edges were given to another thread)
+    std::vector<int> _levelEnds;
+    // Number of times the query's edge times go up, through each query edge
+    std::vector<int> _timeSteps;
+    EdgeRange _allEdges;
+    std::vector<int> _allEdgeIndexes;
+    int _numThreads = 1;
+    Algorithm _algorithm = TIME_ORDER;
+    bool _useSmallQueryKernels = true;
+    // Where to give the matches (null if just counting them)
+    MatchOutput *_output = nullptr;
+    // Where to count the matches by their time span (null if not needed)
+    DeltaCounts *_deltaCounts = nullptr;
+    // Pool the search is running on, and our worker in it (if multi-threaded)
+    WorkStealingPool<OrderedSearchTask> *_pool = nullptr;
+    int _worker = 0;
 };
 
 #endif	/* GRAPHSEARCH_H */
@@ -0,0 +1,483 @@
+#include "GraphSnapshot.h"
+#include "DataGraph.h"
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <fstream>
+#include <iostream>
+#include <memory>
+
+using namespace std;
+
+const char GraphSnapshot::MAGIC[8] = { 'T', 'R', 'I', 'S', 'N', 'A', 'P', '\0' };
+
+/**
+ * A section waiting to be written.  Points either at memory owned by the
+ * graph, or at values created just for the snapshot (kept alive by owner).
+ */
+struct OutSection
+{
+    uint32_t id;
+    const void *data;
+    uint64_t size;
+    shared_ptr<void> owner;
+};
+
+template<typename T>
+static void addSection(vector<OutSection> &sections, uint32_t id, const T *data, size_t count)
+{
+    OutSection section;
+    section.id = id;
+    section.data = data;
+    section.size = count * sizeof(T);
+    sections.push_back(section);
+}
+
+template<typename T>
+static void addSection(vector<OutSection> &sections, uint32_t id, vector<T> &&values)
+{
+    shared_ptr<vector<T>> owner = make_shared<vector<T>>(std::move(values));
+    addSection(sections, id, owner->data(), owner->size());
+    sections.back().owner = owner;
+}
+
+/** Concatenates the given list (edges or edge times) of every node */
+template<typename T, typename GetList>
+static vector<T> concatNodeLists(const vector<Node> &nodes, GetList getList)
+{
+    vector<T> values;
+    for(const Node &node : nodes)
+    {
+        const Column<T> &list = getList(node);
+        values.insert(values.end(), list.begin(), list.end());
+    }
+    return values;
+}
+
+/** Concatenates the given edge list of every node, with the offsets of each node's list */
+template<typename GetList>
+static void addNodeLists(vector<OutSection> &sections, uint32_t offsetsID, uint32_t edgesID, const vector<Node> &nodes, GetList getList)
+{
+    int n = nodes.size();
+    vector<int64_t> offsets(n+1);
+    offsets[0] = 0;
+    for(int u=0; u<n; u++)
+        offsets[u+1] = offsets[u] + getList(nodes[u]).size();
+    addSection(sections, offsetsID, std::move(offsets));
+    addSection(sections, edgesID, concatNodeLists<int>(nodes, getList));
+}
+
+/** Stores the names and types of the attributes in the definition */
+static vector<char> saveAttributesDef(const AttributesDef &def)
+{
+    vector<char> bytes;
+    auto append = [&bytes](const void *data, size_t size)
+    {
+        const char *chars = (const char*)data;
+        bytes.insert(bytes.end(), chars, chars + size);
+    };
+    int32_t n = def.attributeNames().size();
+    append(&n, sizeof(n));
+    for(int i=0; i<n; i++)
+    {
+        int32_t attType = def.attributeTypes()[i];
+        int32_t dataType = def.dataTypes()[i];
+        const string &name = def.attributeNames()[i];
+        int32_t nameSize = name.size();
+        append(&attType, sizeof(attType));
+        append(&dataType, sizeof(dataType));
+        append(&nameSize, sizeof(nameSize));
+        append(name.data(), nameSize);
+    }
+    return bytes;
+}
+
+/** Reads back the definition stored by saveAttributesDef */
+static AttributesDef loadAttributesDef(const char *bytes, uint64_t size)
+{
+    AttributesDef def;
+    uint64_t pos = 0;
+    auto read = [&](void *data, size_t dataSize)
+    {
+        if(pos + dataSize > size)
+            throw "Snapshot attribute definition is truncated.";
+        memcpy(data, bytes + pos, dataSize);
+        pos += dataSize;
+    };
+    int32_t n = 0;
+    read(&n, sizeof(n));
+    for(int i=0; i<n; i++)
+    {
+        int32_t attType, dataType, nameSize;
+        read(&attType, sizeof(attType));
+        read(&dataType, sizeof(dataType));
+        read(&nameSize, sizeof(nameSize));
+        if(nameSize < 0)
+            throw "Snapshot attribute definition is corrupt.";
+        string name(nameSize, '\0');
+        read(&name[0], nameSize);
+        def.addAttribute((AttributeType)attType, (DataType)dataType, name);
+    }
+    return def;
+}
+
+/** Copies the first count values of the column, padding with empty values if it's short */
+template<typename T>
+static vector<T> padColumn(const vector<T> &column, int count)
+{
+    vector<T> values(column.begin(), column.begin() + std::min<size_t>(count, column.size()));
+    values.resize(count);
+    return values;
+}
+
+/** Stores each DATA attribute as its own column, in the order of the definition */
+static void addAttributeColumns(vector<OutSection> &sections, uint32_t baseID, const AttributesDef &def, const AttributesTable &table, int count)
+{
+    int si=0, ii=0, fi=0; // Indices into string columns, int columns, float columns
+    int k=0; // Index of the DATA attribute
+    for(int i=0; i<def.attributeNames().size(); i++)
+    {
+        if(def.attributeTypes()[i] != AttributeType::DATA)
+            continue;
+        uint32_t id = baseID + 3*k;
+        DataType dataType = def.dataTypes()[i];
+        if(dataType == DataType::STRING)
+        {
+            const StringPool &dict = table.dictionary(si);
+            vector<int64_t> offsets;
+            vector<char> chars;
+            offsets.reserve(dict.size()+1);
+            for(int j=0; j<dict.size(); j++)
+            {
+                offsets.push_back(chars.size());
+                StringView str = dict.get(j);
+                chars.insert(chars.end(), str.begin(), str.end());
+            }
+            offsets.push_back(chars.size());
+            addSection(sections, id, padColumn<int32_t>(table.stringColumn(si), count));
+            addSection(sections, id+1, std::move(offsets));
+            addSection(sections, id+2, std::move(chars));
+            si++;
+        }
+        else if(dataType == DataType::INT)
+        {
+            addSection(sections, id, padColumn<int32_t>(table.intColumn(ii), count));
+            ii++;
+        }
+        else if(dataType == DataType::FLOAT)
+        {
+            addSection(sections, id, padColumn<double>(table.floatColumn(fi), count));
+            fi++;
+        }
+        else
+            throw "Can't save attributes to snapshot. Unknown data type.";
+        k++;
+    }
+}
+
+template<typename T>
+const T *GraphSnapshot::getSection(const char *data, const vector<SectionInfo> &sections, uint32_t id, uint64_t count)
+{
+    for(const SectionInfo &section : sections)
+    {
+        if(section.id == id)
+        {
+            if(section.size != count * sizeof(T))
+            {
+                cerr << "Section " << id << " has " << section.size << " bytes, instead of " << count * sizeof(T) << endl;
+                throw "Snapshot section has the wrong size.";
+            }
+            return (const T*)(data + section.offset);
+        }
+    }
+    cerr << "Missing section " << id << endl;
+    throw "Snapshot is missing a section.";
+}
+
+template<typename T>
+const T *GraphSnapshot::getSection(const char *data, const vector<SectionInfo> &sections, uint32_t id, uint64_t *count)
+{
+    for(const SectionInfo &section : sections)
+    {
+        if(section.id == id)
+        {
+            *count = section.size / sizeof(T);
+            return (const T*)(data + section.offset);
+        }
+    }
+    cerr << "Missing section " << id << endl;
+    throw "Snapshot is missing a section.";
+}
+
+/** Fills the columns of the table from the stored columns */
+void GraphSnapshot::loadAttributeColumns(const char *data, const vector<SectionInfo> &sections, uint32_t baseID, const AttributesDef &def, AttributesTable &table)
+{
+    int si=0, ii=0, fi=0; // Indices into string columns, int columns, float columns
+    int k=0; // Index of the DATA attribute
+    int count = table.size();
+    for(int i=0; i<def.attributeNames().size(); i++)
+    {
+        if(def.attributeTypes()[i] != AttributeType::DATA)
+            continue;
+        uint32_t id = baseID + 3*k;
+        DataType dataType = def.dataTypes()[i];
+        if(dataType == DataType::STRING)
+        {
+            const int32_t *ids = getSection<int32_t>(data, sections, id, count);
+            uint64_t numOffsets = 0, numChars = 0;
+            const int64_t *offsets = getSection<int64_t>(data, sections, id+1, &numOffsets);
+            const char *chars = getSection<char>(data, sections, id+2, &numChars);
+            if(numOffsets == 0)
+                throw "Snapshot string column is corrupt.";
+            int numStrings = numOffsets - 1;
+            StringPool &dict = table.dictionary(si);
+            dict.clear();
+            dict.reserve(numStrings, numChars);
+            for(int j=0; j<numStrings; j++)
+            {
+                if(offsets[j] > offsets[j+1] || (uint64_t)offsets[j+1] > numChars)
+                    throw "Snapshot string column is corrupt.";
+                if(dict.intern(StringView(chars + offsets[j], offsets[j+1] - offsets[j])) != j)
+                    throw "Snapshot string column has duplicate strings.";
+            }
+            vector<int> &column = table.stringColumn(si);
+            column.assign(ids, ids + count);
+            for(int stringID : column)
+                if(stringID < -1 || stringID >= numStrings)
+                    throw "Snapshot string column is corrupt.";
+            si++;
+        }
+        else if(dataType == DataType::INT)
+        {
+            const int32_t *values = getSection<int32_t>(data, sections, id, count);
+            table.intColumn(ii).assign(values, values + count);
+            ii++;
+        }
+        else if(dataType == DataType::FLOAT)
+        {
+            const double *values = getSection<double>(data, sections, id, count);
+            table.floatColumn(fi).assign(values, values + count);
+            fi++;
+        }
+        else
+            throw "Can't load attributes from snapshot. Unknown data type.";
+        k++;
+    }
+}
+
+void GraphSnapshot::save(const DataGraph &g, const string &fname)
+{
+    // Make sure the edges and pair index are up to date
+    const EdgeList &edges = g.edges();
+    if(!g._pairIndexReady)
+        g.updatePairIndex();
+    const vector<Node> &nodes = g.nodes();
+    int n = nodes.size();
+    int m = edges.size();
+
+    vector<OutSection> sections;
+    addSection(sections, EDGE_SOURCES, edges.sources().data(), m);
+    addSection(sections, EDGE_DESTS, edges.dests().data(), m);
+    addSection(sections, EDGE_TIMES, edges.times().data(), m);
+    addNodeLists(sections, NODE_OUT_OFFSETS, NODE_OUT_EDGES, nodes, [](const Node &node) -> const Column<int>& { return node.outEdges(); });
+    addNodeLists(sections, NODE_IN_OFFSETS, NODE_IN_EDGES, nodes, [](const Node &node) -> const Column<int>& { return node.inEdges(); });
+    addNodeLists(sections, NODE_ALL_OFFSETS, NODE_ALL_EDGES, nodes, [](const Node &node) -> const Column<int>& { return node.edges(); });
+    // The edge times of each node share the offsets of its in/out edge lists
+    addSection(sections, NODE_OUT_TIMES, concatNodeLists<time_t>(nodes, [](const Node &node) -> const Column<time_t>& { return node.outEdgeTimes(); }));
+    addSection(sections, NODE_IN_TIMES, concatNodeLists<time_t>(nodes, [](const Node &node) -> const Column<time_t>& { return node.inEdgeTimes(); }));
+    addSection(sections, PAIR_OFFSETS, g._pairOffsets.data(), g._pairOffsets.size());
+    addSection(sections, PAIR_DESTS, g._pairDests.data(), g._pairDests.size());
+    addSection(sections, PAIR_EDGE_OFFSETS, g._pairEdgeOffsets.data(), g._pairEdgeOffsets.size());
+    addSection(sections, PAIR_EDGES, g._pairEdges.data(), g._pairEdges.size());
+
+    // Node names
+    vector<int64_t> nameOffsets;
+    vector<char> nameChars;
+    nameOffsets.reserve(n+1);
+    for(int u=0; u<n; u++)
+    {
+        nameOffsets.push_back(nameChars.size());
+        StringView name = g.getName(u);
+        nameChars.insert(nameChars.end(), name.begin(), name.end());
+    }
+    nameOffsets.push_back(nameChars.size());
+    addSection(sections, NODE_NAME_OFFSETS, std::move(nameOffsets));
+    addSection(sections, NODE_NAME_CHARS, std::move(nameChars));
+
+    // Attributes
+    addSection(sections, NODE_ATTRIBUTES_DEF, saveAttributesDef(g.nodeAttributesDef()));
+    addSection(sections, EDGE_ATTRIBUTES_DEF, saveAttributesDef(g.edgeAttributesDef()));
+    addAttributeColumns(sections, NODE_ATTRIBUTES, g.nodeAttributesDef(), g.nodeAttributes(), n);
+    addAttributeColumns(sections, EDGE_ATTRIBUTES, g.edgeAttributesDef(), g.edgeAttributes(), m);
+
+    // Lay out the sections after the header and section table
+    Header header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.byteOrder = BYTE_ORDER_MARK;
+    header.numNodes = n;
+    header.numEdges = m;
+    header.numPairs = g._pairDests.size();
+    header.numSections = sections.size();
+    vector<SectionInfo> infos(sections.size());
+    uint64_t offset = sizeof(Header) + sections.size() * sizeof(SectionInfo);
+    for(int i=0; i<sections.size(); i++)
+    {
+        offset = (offset + 7) & ~(uint64_t)7;
+        memset(&infos[i], 0, sizeof(SectionInfo));
+        infos[i].id = sections[i].id;
+        infos[i].offset = offset;
+        infos[i].size = sections[i].size;
+        offset += sections[i].size;
+    }
+
+    ofstream ofs(fname, ios::binary);
+    if(!ofs.good())
+        throw "Unable to open snapshot file for writing.";
+    ofs.write((const char*)&header, sizeof(header));
+    ofs.write((const char*)infos.data(), infos.size() * sizeof(SectionInfo));
+    uint64_t pos = sizeof(Header) + infos.size() * sizeof(SectionInfo);
+    const char padding[8] = {0};
+    for(int i=0; i<sections.size(); i++)
+    {
+        ofs.write(padding, infos[i].offset - pos);
+        ofs.write((const char*)sections[i].data, sections[i].size);
+        pos = infos[i].offset + sections[i].size;
+    }
+    if(!ofs.good())
+        throw "Problem writing snapshot file.";
+    ofs.close();
+}
+
+DataGraph GraphSnapshot::load(const string &fname)
+{
+    // Map the whole file into memory
+    int fd = open(fname.c_str(), O_RDONLY);
+    if(fd < 0)
+        throw "Unable to open snapshot file.";
+    struct stat st;
+    if(fstat(fd, &st) != 0)
+    {
+        close(fd);
+        throw "Unable to get the size of the snapshot file.";
+    }
+    uint64_t fileSize = st.st_size;
+    if(fileSize < sizeof(Header))
+    {
+        close(fd);
+        throw "Snapshot file is too small.";
+    }
+    void *addr = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(addr == MAP_FAILED)
+        throw "Unable to memory map the snapshot file.";
+    // Unmapped once the graph (and all copies of it) are done with it
+    shared_ptr<const void> mapping(addr, [fileSize](const void *p) { munmap((void*)p, fileSize); });
+    const char *data = (const char*)addr;
+
+    // Check the header and section table
+    const Header &header = *(const Header*)data;
+    if(memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0)
+        throw "File is not a graph snapshot.";
+    if(header.byteOrder != BYTE_ORDER_MARK)
+        throw "Snapshot was saved on a machine with a different byte order.";
+    if(header.version != VERSION)
+    {
+        cerr << "Snapshot version " << header.version << ", expected version " << VERSION << endl;
+        throw "Unsupported snapshot version.";
+    }
+    if(header.numNodes < 0 || header.numEdges < 0 || header.numPairs < 0 ||
+       header.numNodes > INT32_MAX || header.numEdges > INT32_MAX)
+        throw "Snapshot header is corrupt.";
+    uint64_t tableEnd = sizeof(Header) + (uint64_t)header.numSections * sizeof(SectionInfo);
+    if(tableEnd > fileSize)
+        throw "Snapshot section table is truncated.";
+    const SectionInfo *table = (const SectionInfo*)(data + sizeof(Header));
+    vector<SectionInfo> sections(table, table + header.numSections);
+    for(const SectionInfo &section : sections)
+    {
+        if(section.offset < tableEnd || section.offset % 8 != 0 || section.offset > fileSize || section.size > fileSize - section.offset)
+            throw "Snapshot section is out of bounds.";
+    }
+
+    int n = header.numNodes;
+    int m = header.numEdges;
+    int numPairs = header.numPairs;
+
+    DataGraph g;
+    Graph &base = g;
+
+    // Use the edge columns and indexes in place
+    const int *sources = getSection<int>(data, sections, EDGE_SOURCES, m);
+    const int *dests = getSection<int>(data, sections, EDGE_DESTS, m);
+    const time_t *times = getSection<time_t>(data, sections, EDGE_TIMES, m);
+    base._edges.borrow(sources, dests, times, m);
+    base._numEdges = m;
+
+    const int64_t *outOffsets = getSection<int64_t>(data, sections, NODE_OUT_OFFSETS, n+1);
+    const int *outEdges = getSection<int>(data, sections, NODE_OUT_EDGES, m);
+    const int64_t *inOffsets = getSection<int64_t>(data, sections, NODE_IN_OFFSETS, n+1);
+    const int *inEdges = getSection<int>(data, sections, NODE_IN_EDGES, m);
+    const int64_t *allOffsets = getSection<int64_t>(data, sections, NODE_ALL_OFFSETS, n+1);
+    const int *allEdges = getSection<int>(data, sections, NODE_ALL_EDGES, 2*(uint64_t)m);
+    const time_t *outTimes = getSection<time_t>(data, sections, NODE_OUT_TIMES, m);
+    const time_t *inTimes = getSection<time_t>(data, sections, NODE_IN_TIMES, m);
+    if(outOffsets[n] != m || inOffsets[n] != m || allOffsets[n] != 2*(int64_t)m)
+        throw "Snapshot node edge lists are corrupt.";
+    base._nodes.resize(n);
+    for(int u=0; u<n; u++)
+    {
+        Node &node = base._nodes[u];
+        node.outEdges().borrow(outEdges + outOffsets[u], outOffsets[u+1] - outOffsets[u]);
+        node.inEdges().borrow(inEdges + inOffsets[u], inOffsets[u+1] - inOffsets[u]);
+        node.edges().borrow(allEdges + allOffsets[u], allOffsets[u+1] - allOffsets[u]);
+        node.outEdgeTimes().borrow(outTimes + outOffsets[u], outOffsets[u+1] - outOffsets[u]);
+        node.inEdgeTimes().borrow(inTimes + inOffsets[u], inOffsets[u+1] - inOffsets[u]);
+    }
+
+    base._pairOffsets.borrow(getSection<int>(data, sections, PAIR_OFFSETS, n+1), n+1);
+    base._pairDests.borrow(getSection<int>(data, sections, PAIR_DESTS, numPairs), numPairs);
+    base._pairEdgeOffsets.borrow(getSection<int>(data, sections, PAIR_EDGE_OFFSETS, numPairs+1), numPairs+1);
+    base._pairEdges.borrow(getSection<int>(data, sections, PAIR_EDGES, m), m);
+    base._pairIndexReady = true;
+
+    // Everything is already in chronological order
+    base._firstUpdatedEdge = m;
+    base._numPrevEdges = m;
+    base._edgesReady = true;
+    base._snapshot = mapping;
+
+    // Node names
+    const int64_t *nameOffsets = getSection<int64_t>(data, sections, NODE_NAME_OFFSETS, n+1);
+    uint64_t numNameChars = 0;
+    const char *nameChars = getSection<char>(data, sections, NODE_NAME_CHARS, &numNameChars);
+    g._nodeNames.reserve(n, numNameChars);
+    g._nodeNameIds.resize(n);
+    g._nameNodes.resize(n);
+    for(int u=0; u<n; u++)
+    {
+        if(nameOffsets[u] > nameOffsets[u+1] || (uint64_t)nameOffsets[u+1] > numNameChars)
+            throw "Snapshot node names are corrupt.";
+        int id = g._nodeNames.intern(StringView(nameChars + nameOffsets[u], nameOffsets[u+1] - nameOffsets[u]));
+        g._nodeNameIds[u] = id;
+        g._nameNodes[id] = u;
+    }
+    g._nameNodes.resize(g._nodeNames.size());
+
+    // Attributes
+    uint64_t defSize = 0;
+    const char *nodeDef = getSection<char>(data, sections, NODE_ATTRIBUTES_DEF, &defSize);
+    g.setNodeAttributesDef(loadAttributesDef(nodeDef, defSize));
+    const char *edgeDef = getSection<char>(data, sections, EDGE_ATTRIBUTES_DEF, &defSize);
+    g.setEdgeAttributesDef(loadAttributesDef(edgeDef, defSize));
+    g._nodeAttributes.resize(n);
+    loadAttributeColumns(data, sections, NODE_ATTRIBUTES, g._nodeAttributesDef, g._nodeAttributes);
+    g._edgeAttributes.resize(m);
+    loadAttributeColumns(data, sections, EDGE_ATTRIBUTES, g._edgeAttributesDef, g._edgeAttributes);
+
+    return g;
+}
+
@@ -0,0 +1,111 @@
+/*
+ * File:   GraphSnapshot.h
+ * Author: D3M430
+ *
+ * Created on March 10, 2021, 9:30 AM
+ */
+
+#ifndef GRAPHSNAPSHOT_H
+#define	GRAPHSNAPSHOT_H
+
+#include "DataGraph.h"
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+/**
+ * Versioned binary snapshot of a DataGraph, with its edge columns and
+ * indexes already built.  Loading one memory maps the file, and the graph
+ * uses the edge columns, node edge lists and pair index in place, so
+ * nothing needs to be parsed or sorted.
+ *
+ * The file starts with a Header, followed by a table of numSections
+ * SectionInfo entries, followed by the sections themselves (each aligned
+ * to 8 bytes).  All values are stored in the native byte order of the
+ * machine that wrote it.
+ */
+class GraphSnapshot
+{
+public:
+    /** Current version of the file format */
+    static const uint32_t VERSION = 3;
+
+    /**
+     * Saves the graph, including its indexes, as a snapshot.
+     * @param g  Graph we want to save.
+     * @param fname  Name of the snapshot file to save it to.
+     */
+    static void save(const DataGraph &g, const std::string &fname);
+
+    /**
+     * Loads a graph from a snapshot.  The file is memory mapped, and stays
+     * mapped for as long as the graph (or any copy of it) uses it.
+     * @param fname  Name of the snapshot file.
+     * @return  The graph stored in the snapshot.
+     */
+    static DataGraph load(const std::string &fname);
+
+private:
+    /** IDs of the sections stored in the file */
+    enum SectionID : uint32_t
+    {
+        EDGE_SOURCES = 1,
+        EDGE_DESTS,
+        EDGE_TIMES,
+        NODE_OUT_OFFSETS,
+        NODE_OUT_EDGES,
+        NODE_IN_OFFSETS,
+        NODE_IN_EDGES,
+        NODE_ALL_OFFSETS,
+        NODE_ALL_EDGES,
+        PAIR_OFFSETS,
+        PAIR_DESTS,
+        PAIR_EDGE_OFFSETS,
+        PAIR_EDGES,
+        NODE_NAME_OFFSETS,
+        NODE_NAME_CHARS,
+        NODE_ATTRIBUTES_DEF,
+        EDGE_ATTRIBUTES_DEF,
+        NODE_OUT_TIMES,
+        NODE_IN_TIMES,
+        // Attribute columns use three IDs each, starting at these values
+        // (values or string dictionary IDs first, then the dictionary's
+        // string offsets and characters)
+        NODE_ATTRIBUTES = 1000,
+        EDGE_ATTRIBUTES = 2000
+    };
+
+    struct Header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t byteOrder;
+        int64_t numNodes;
+        int64_t numEdges;
+        int64_t numPairs;
+        uint32_t numSections;
+        uint32_t reserved;
+    };
+
+    struct SectionInfo
+    {
+        uint32_t id;
+        uint32_t reserved;
+        uint64_t offset;
+        uint64_t size;
+    };
+
+    static const char MAGIC[8];
+    static const uint32_t BYTE_ORDER_MARK = 0x01020304;
+
+    /** Finds a section that must hold exactly count values of type T */
+    template<typename T>
+    static const T *getSection(const char *data, const std::vector<SectionInfo> &sections, uint32_t id, uint64_t count);
+    /** Finds a section of any length, returning its number of values in count */
+    template<typename T>
+    static const T *getSection(const char *data, const std::vector<SectionInfo> &sections, uint32_t id, uint64_t *count);
+    static void loadAttributeColumns(const char *data, const std::vector<SectionInfo> &sections, uint32_t baseID, const AttributesDef &def, AttributesTable &table);
+};
+
+#endif	/* GRAPHSNAPSHOT_H */
+
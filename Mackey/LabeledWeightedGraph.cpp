@@ -7,12 +7,12 @@ void LabeledWeightedGraph::addWeightedEdge(int u, int v, time_t dateTime, double
 {
     Graph::addEdge(u, v, dateTime);
     //this->_edgeWeights.push_back(weight);  
-    _timeEdgeWeightMap[dateTime].push_back(weight);
+    _newEdgeWeights.push_back(weight);
     
     // Make sure that labels are all accounted for
-    if(max(u,v) >= _nodeLabels.size())
+    if(max(u,v) >= _nodeLabelIds.size())
     {
-        _nodeLabels.resize(max(u,v)+1);
+        _nodeLabelIds.resize(max(u,v)+1,-1);
     }
 }
 
@@ -20,12 +20,12 @@ void LabeledWeightedGraph::addEdge(int u, int v, time_t dateTime)
 {
     Graph::addEdge(u, v, dateTime);
     //this->_edgeWeights.push_back(0.0);
-    _timeEdgeWeightMap[dateTime].push_back(0.0);
+    _newEdgeWeights.push_back(0.0);
     
     // Make sure that labels are all accounted for
-    if(max(u,v) >= _nodeLabels.size())
+    if(max(u,v) >= _nodeLabelIds.size())
     {
-        _nodeLabels.resize(max(u,v)+1);
+        _nodeLabelIds.resize(max(u,v)+1,-1);
     }
 }
 
@@ -42,17 +42,20 @@ void LabeledWeightedGraph::copyEdge(int edgeIndex, const Graph& g)
         this->addLabeledNode(v, wg.getLabel(v));
 }
 
-void LabeledWeightedGraph::addLabeledNode(int v, std::string label)
+void LabeledWeightedGraph::addLabeledNode(int v, StringView label)
 {
     if(v < 0)
         throw "Vertices must be >= 0";
     this->addNode(v);
-    if(this->_nodeLabels.size() <= v)
+    if(this->_nodeLabelIds.size() <= v)
     {
-        _nodeLabels.resize(v+1);
+        _nodeLabelIds.resize(v+1,-1);
     }
-    _nodeLabels[v] = label;
-    _nameMap[label] = v;    
+    int id = _labels.intern(label);
+    _nodeLabelIds[v] = id;
+    if(_labelNodes.size() <= id)
+        _labelNodes.resize(id+1);
+    _labelNodes[id] = v;
 }
 
 double LabeledWeightedGraph::getEdgeWeight(int edgeIndex) const
@@ -60,14 +63,17 @@ double LabeledWeightedGraph::getEdgeWeight(int edgeIndex) const
     return _edgeWeights[edgeIndex]; 
 }
 
-const string &LabeledWeightedGraph::getLabel(int nodeIndex) const
+StringView LabeledWeightedGraph::getLabel(int nodeIndex) const
 {    
-    return _nodeLabels[nodeIndex];
+    int id = _nodeLabelIds[nodeIndex];
+    if(id < 0)
+        return StringView();
+    return _labels.get(id);
 }
 
-int LabeledWeightedGraph::getIndex(const std::string &nodeLabel) const
+int LabeledWeightedGraph::getIndex(StringView nodeLabel) const
 {
-    return _nameMap.find(nodeLabel)->second;
+    return _labelNodes[_labels.find(nodeLabel)];
 }
 
 void LabeledWeightedGraph::disp() const
@@ -108,19 +114,8 @@ void LabeledWeightedGraph::updateOrderedEdges() const
     // Make sure base class is updated first
     Graph::updateOrderedEdges();
     
-    // Clear old edge weights
-    _edgeWeights.clear();
-    
-    // Build edge list in chronological order
-    for(auto &pair : _timeEdgeWeightMap)
-    {
-        time_t dateTime = pair.first;
-        const vector<double> &weights = _timeEdgeWeightMap.find(dateTime)->second;
-        for(double w : weights)
-        {
-            _edgeWeights.push_back(w);
-        }
-    }
+    // Put edge weights in chronological order
+    this->reorderEdgeValues(_edgeWeights, _newEdgeWeights);
 }
 
 
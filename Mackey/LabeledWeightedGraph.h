@@ -9,6 +9,7 @@
 #define	LABELED_WEIGHTED_GRAPH_H
 
 #include "Graph.h"
+#include "StringPool.h"
 #include "WeightRestriction.h"
 #include <string>
 #include <unordered_map>
@@ -21,7 +22,7 @@ class LabeledWeightedGraph : public Graph
 public:
     LabeledWeightedGraph(int windowDuration=0) : Graph(windowDuration) {}
     /** Adds a node with the appropriate label. (Nodes will have blank string otherwise.) */
-    virtual void addLabeledNode(int v, std::string label);
+    virtual void addLabeledNode(int v, StringView label);
     /** Adds edge with 0.0 weight */
     virtual void addEdge(int u, int v, time_t dateTime) override;
     /** Adds edge with the given weight */
@@ -33,11 +34,11 @@ public:
     /** Gets the weight of the edge */
     double getEdgeWeight(int edgeIndex) const;
     /** Gets the label of the node */
-    const std::string &getLabel(int nodeIndex) const;    
+    StringView getLabel(int nodeIndex) const;    
     /** Returns true if there is a node with the given label */
-    bool hasLabeledNode(const std::string &label) const { return _nameMap.find(label) != _nameMap.end(); }
+    bool hasLabeledNode(StringView label) const { return _labels.find(label) >= 0; }
     /** Gets the index of the labeled node */
-    int getIndex(const std::string &nodeLabel) const;
+    int getIndex(StringView nodeLabel) const;
     /** Displays nodes/edges including metadata */
     void disp() const override;
     /** Displays edge information for the given edge */
@@ -58,9 +59,14 @@ protected:
     virtual void updateOrderedEdges() const override;
     
 private:
-    std::vector<std::string> _nodeLabels;
-    std::unordered_map<std::string,int> _nameMap;
-    std::map<time_t,std::vector<double>> _timeEdgeWeightMap;
+    // Node labels, stored once each
+    StringPool _labels;
+    // Label ID of each node (-1 if it has no label)
+    std::vector<int> _nodeLabelIds;
+    // Node for each label ID
+    std::vector<int> _labelNodes;
+    // Edge weights for the edges added since the ordered edges were last updated
+    mutable std::vector<double> _newEdgeWeights;
     mutable std::vector<double> _edgeWeights;
     std::unordered_map<int,std::vector<WeightRestriction>> _weightRestricts;
 };
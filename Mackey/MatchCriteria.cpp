@@ -11,3 +11,14 @@ bool MatchCriteria::isNodeMatch(const Graph &g, int gNodeIndex, const Graph &h,
 {
     return true;
 }
+
+bool MatchCriteria::isSameEdgeCriteria(const Graph &h1, int h1EdgeIndex, const Graph &h2, int h2EdgeIndex) const
+{
+    // Only the time window of the searched graph matters
+    return true;
+}
+
+bool MatchCriteria::isSameNodeCriteria(const Graph &h1, int h1NodeIndex, const Graph &h2, int h2NodeIndex) const
+{
+    return true;
+}
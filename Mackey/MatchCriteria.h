@@ -40,6 +40,29 @@ public:
      * @return  True if the graph edge matches the criteria of the query edge.
      */
     virtual bool isNodeMatch(const Graph &g, int gNodeIndex, const Graph &h, int hNodeIndex) const;
+    
+    /**
+     * Returns true if two query edges (possibly from different query graphs)
+     * have the same criteria, so they always match the same edges.  Used to
+     * search for several queries at once.
+     * @param h1  The first query graph.
+     * @param h1EdgeIndex  The index of the edge in the first query graph.
+     * @param h2  The second query graph.
+     * @param h2EdgeIndex  The index of the edge in the second query graph.
+     * @return  True if the query edges match the same edges.
+     */
+    virtual bool isSameEdgeCriteria(const Graph &h1, int h1EdgeIndex, const Graph &h2, int h2EdgeIndex) const;
+    
+    /**
+     * Returns true if two query nodes (possibly from different query graphs)
+     * have the same criteria, so they always match the same nodes.
+     * @param h1  The first query graph.
+     * @param h1NodeIndex  The index of the node in the first query graph.
+     * @param h2  The second query graph.
+     * @param h2NodeIndex  The index of the node in the second query graph.
+     * @return  True if the query nodes match the same nodes.
+     */
+    virtual bool isSameNodeCriteria(const Graph &h1, int h1NodeIndex, const Graph &h2, int h2NodeIndex) const;
 };
 
 #endif	/* EDGEMATCHCRITERIA_H */
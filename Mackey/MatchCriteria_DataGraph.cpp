@@ -14,7 +14,7 @@ bool MatchCriteria_DataGraph::isEdgeMatch(const Graph& g, int gEdgeIndex, const
     DataGraph &dh = (DataGraph&)h;
     
     // Check edge attributes first
-    if(this->doAttributesMatch(dg.edgeAttributes()[gEdgeIndex], dh.edgeAttributes()[hEdgeIndex]) == false)
+    if(this->doAttributesMatch(dg.edgeAttributes(), gEdgeIndex, dh.edgeAttributes(), hEdgeIndex) == false)
         return false;
         
     const Edge &hEdge = dh.edges()[hEdgeIndex];
@@ -45,7 +45,7 @@ bool MatchCriteria_DataGraph::isNodeMatch(const Graph &g, int gNodeIndex, const
     DataGraph &dh = (DataGraph&)h;
     
     // Check node attributes first
-    if(this->doAttributesMatch(dg.nodeAttributes()[gNodeIndex], dh.nodeAttributes()[hNodeIndex]) == false)
+    if(this->doAttributesMatch(dg.nodeAttributes(), gNodeIndex, dh.nodeAttributes(), hNodeIndex) == false)
         return false;
 
     // TODO: May want to also look at adjacent edges, like we do
@@ -55,29 +55,119 @@ bool MatchCriteria_DataGraph::isNodeMatch(const Graph &g, int gNodeIndex, const
     return true;
 }
 
-bool MatchCriteria_DataGraph::doAttributesMatch(const Attributes& a1, const Attributes& a2) const
+bool MatchCriteria_DataGraph::isSameEdgeCriteria(const Graph &h1, int h1EdgeIndex, const Graph &h2, int h2EdgeIndex) const
 {
-    if(a1.floatValues().size() != a2.floatValues().size() ||
-       a1.intValues().size() != a2.intValues().size() ||
-       a1.stringValues().size() != a2.stringValues().size())
+    DataGraph &dh1 = (DataGraph&)h1;
+    DataGraph &dh2 = (DataGraph&)h2;
+    
+    if(this->doAttributesAgree(dh1.edgeAttributes(), h1EdgeIndex, dh2.edgeAttributes(), h2EdgeIndex) == false)
+        return false;
+    
+    // Edges also test their nodes
+    const Edge &e1 = dh1.edges()[h1EdgeIndex];
+    const Edge &e2 = dh2.edges()[h2EdgeIndex];
+    return isSameNodeCriteria(h1, e1.source(), h2, e2.source()) && isSameNodeCriteria(h1, e1.dest(), h2, e2.dest());
+}
+
+bool MatchCriteria_DataGraph::isSameNodeCriteria(const Graph &h1, int h1NodeIndex, const Graph &h2, int h2NodeIndex) const
+{
+    DataGraph &dh1 = (DataGraph&)h1;
+    DataGraph &dh2 = (DataGraph&)h2;
+    return this->doAttributesAgree(dh1.nodeAttributes(), h1NodeIndex, dh2.nodeAttributes(), h2NodeIndex);
+}
+
+namespace
+{
+    /** True if two numeric query values (and their restrictions, if any) match the same values */
+    template<typename T, typename R>
+    bool sameNumericCriteria(T x1, const std::vector<R> &restrictions1, int i1, T x2, const std::vector<R> &restrictions2, int i2)
+    {
+        // Columns without restrictions only hold exact values
+        R r1 = restrictions1.empty() ? R() : restrictions1[i1];
+        R r2 = restrictions2.empty() ? R() : restrictions2[i2];
+        if(r1.any() || r2.any())
+            return r1.any() && r2.any();
+        if(r1.exact() != r2.exact() || r1.hasMin() != r2.hasMin() || r1.hasMax() != r2.hasMax())
+            return false;
+        if(r1.exact() && x1 != x2)
+            return false;
+        if(r1.hasMin() && r1.min() != r2.min())
+            return false;
+        if(r1.hasMax() && r1.max() != r2.max())
+            return false;
+        return true;
+    }
+}
+
+bool MatchCriteria_DataGraph::doAttributesAgree(const AttributesTable &t1, int i1, const AttributesTable &t2, int i2) const
+{
+    if(t1.numFloatColumns() != t2.numFloatColumns() ||
+       t1.numIntColumns() != t2.numIntColumns() ||
+       t1.numStringColumns() != t2.numStringColumns())
+        throw "Can't compare attributes. Number of attributes of each type don't match!";
+    
+    for(int k=0; k<t1.numFloatColumns(); k++)
+    {
+        if(!sameNumericCriteria(t1.floatColumn(k)[i1], t1.floatRestrictions(k), i1, t2.floatColumn(k)[i2], t2.floatRestrictions(k), i2))
+            return false;
+    }
+    
+    for(int k=0; k<t1.numIntColumns(); k++)
+    {
+        if(!sameNumericCriteria(t1.intColumn(k)[i1], t1.intRestrictions(k), i1, t2.intColumn(k)[i2], t2.intRestrictions(k), i2))
+            return false;
+    }
+    
+    for(int k=0; k<t1.numStringColumns(); k++)
+    {
+        bool any1 = !t1.stringRestrictions(k).empty() && t1.stringRestrictions(k)[i1].any();
+        bool any2 = !t2.stringRestrictions(k).empty() && t2.stringRestrictions(k)[i2].any();
+        if(any1 || any2)
+        {
+            if(any1 != any2)
+                return false;
+            continue;
+        }
+        if(t1.sharesDictionary(k, t2))
+        {
+            if(t1.stringColumn(k)[i1] != t2.stringColumn(k)[i2])
+                return false;
+        }
+        else if(t1.stringValue(k, i1) != t2.stringValue(k, i2))
+            return false;
+    }
+    return true;
+}
+
+bool MatchCriteria_DataGraph::doAttributesMatch(const AttributesTable &t1, int i1, const AttributesTable &t2, int i2) const
+{
+    if(t1.numFloatColumns() != t2.numFloatColumns() ||
+       t1.numIntColumns() != t2.numIntColumns() ||
+       t1.numStringColumns() != t2.numStringColumns())
     {
         cerr << "First attributes set:" << endl;
-        cerr << a1.floatValues().size() << " floats" << endl;
-        cerr << a1.intValues().size() << " ints" << endl;
-        cerr << a1.stringValues().size() << " strings" << endl;
+        cerr << t1.numFloatColumns() << " floats" << endl;
+        cerr << t1.numIntColumns() << " ints" << endl;
+        cerr << t1.numStringColumns() << " strings" << endl;
         cerr << "Second attributes set:" << endl;
-        cerr << a2.floatValues().size() << " floats" << endl;
-        cerr << a2.intValues().size() << " ints" << endl;
-        cerr << a2.stringValues().size() << " strings" << endl;
+        cerr << t2.numFloatColumns() << " floats" << endl;
+        cerr << t2.numIntColumns() << " ints" << endl;
+        cerr << t2.numStringColumns() << " strings" << endl;
         throw "Can't compare attributes. Number of attributes of each type don't match!";
     }
     
-    const auto &f1 = a1.floatValues();
-    const auto &f2 = a2.floatValues();
-    for(int i=0; i<f1.size(); i++)
+    // Columns without restrictions only hold exact values
+    for(int k=0; k<t1.numFloatColumns(); k++)
     {
-        float x1 = f1[i], x2 = f2[i];
-        FloatRestrictions r2 = a2.floatRestrictions()[i];
+        float x1 = t1.floatColumn(k)[i1], x2 = t2.floatColumn(k)[i2];
+        const auto &restrictions = t2.floatRestrictions(k);
+        if(restrictions.empty())
+        {
+            if(x1 != x2)
+                return false;
+            continue;
+        }
+        const FloatRestrictions &r2 = restrictions[i2];
         if(r2.any())
             continue;
         if(r2.hasMin() && x1 < r2.min())
@@ -88,12 +178,17 @@ bool MatchCriteria_DataGraph::doAttributesMatch(const Attributes& a1, const Attr
             return false;        
     }
     
-    const auto &i1 = a1.intValues();
-    const auto &i2 = a2.intValues();
-    for(int i=0; i<i1.size(); i++)
+    for(int k=0; k<t1.numIntColumns(); k++)
     {
-        int x1 = i1[i], x2 = i2[i];
-        IntRestrictions r2 = a2.intRestrictions()[i];
+        int x1 = t1.intColumn(k)[i1], x2 = t2.intColumn(k)[i2];
+        const auto &restrictions = t2.intRestrictions(k);
+        if(restrictions.empty())
+        {
+            if(x1 != x2)
+                return false;
+            continue;
+        }
+        const IntRestrictions &r2 = restrictions[i2];
         if(r2.any())
             continue;
         if(r2.hasMin() && x1 < r2.min())
@@ -104,14 +199,20 @@ bool MatchCriteria_DataGraph::doAttributesMatch(const Attributes& a1, const Attr
             return false;        
     }
     
-    const auto &s1 = a1.stringValues();
-    const auto &s2 = a2.stringValues();
-    for(int i=0; i<s1.size(); i++)
+    for(int k=0; k<t1.numStringColumns(); k++)
     {
-        StringRestrictions r2 = a2.stringRestrictions()[i];
-        if(r2.any())
+        const auto &restrictions = t2.stringRestrictions(k);
+        if(!restrictions.empty() && restrictions[i2].any())
             continue;
-        if(r2.exact() && s1[i] != s2[i])
+        // With the same dictionary, equal strings have equal IDs.  (A query
+        // string missing from the dictionary is -1, so matches nothing.)
+        if(t1.sharesDictionary(k, t2))
+        {
+            int id2 = t2.stringColumn(k)[i2];
+            if(id2 < 0 || t1.stringColumn(k)[i1] != id2)
+                return false;
+        }
+        else if(t1.stringValue(k, i1) != t2.stringValue(k, i2))
             return false;
     }
     return true;
@@ -2,6 +2,7 @@
 #define MATCH_CRITERIA_DATA_GRAPH_H
 
 #include "Attributes.h"
+#include "AttributesTable.h"
 #include "DataGraph.h"
 #include "Graph.h"
 #include "MatchCriteria.h"
@@ -38,9 +39,45 @@ public:
     virtual bool isNodeMatch(const Graph &g, int gNodeIndex, const Graph &h, int hNodeIndex) const override;
     
     /**
-     * Returns true if the attributes match.
+     * Returns true if the attributes of a node/edge from the searched graph
+     * match the attributes (and restrictions) of one from the query graph.
+     * @param t1  Attributes of the searched graph.
+     * @param i1  Row (node or edge index) in the searched graph.
+     * @param t2  Attributes of the query graph.
+     * @param i2  Row (node or edge index) in the query graph.
      */
-    virtual bool doAttributesMatch(const Attributes &a1, const Attributes &a2) const;
+    virtual bool doAttributesMatch(const AttributesTable &t1, int i1, const AttributesTable &t2, int i2) const;
+    
+    /**
+     * Returns true if two query edges have the same attributes (and
+     * restrictions), and so do their nodes.
+     * @param h1  The first query graph.
+     * @param h1EdgeIndex  The index of the edge in the first query graph.
+     * @param h2  The second query graph.
+     * @param h2EdgeIndex  The index of the edge in the second query graph.
+     * @return  True if the query edges match the same edges.
+     */
+    virtual bool isSameEdgeCriteria(const Graph &h1, int h1EdgeIndex, const Graph &h2, int h2EdgeIndex) const override;
+    
+    /**
+     * Returns true if two query nodes have the same attributes (and restrictions).
+     * @param h1  The first query graph.
+     * @param h1NodeIndex  The index of the node in the first query graph.
+     * @param h2  The second query graph.
+     * @param h2NodeIndex  The index of the node in the second query graph.
+     * @return  True if the query nodes match the same nodes.
+     */
+    virtual bool isSameNodeCriteria(const Graph &h1, int h1NodeIndex, const Graph &h2, int h2NodeIndex) const override;
+    
+    /**
+     * Returns true if the attributes (and restrictions) of a node/edge from
+     * one query graph match the same values as those of one from another.
+     * @param t1  Attributes of the first query graph.
+     * @param i1  Row (node or edge index) in the first query graph.
+     * @param t2  Attributes of the second query graph.
+     * @param i2  Row (node or edge index) in the second query graph.
+     */
+    virtual bool doAttributesAgree(const AttributesTable &t1, int i1, const AttributesTable &t2, int i2) const;
 };
 
 
@@ -0,0 +1,62 @@
+#include "MatchCriteria_Labels.h"
+
+using namespace std;
+
+MatchCriteria_Labels::MatchCriteria_Labels(const DataGraph &g, const DataGraph &h)
+{
+    _windowStart = g.windowStart();
+    _windowEnd = g.windowEnd();
+    _times = g.edges().times().data();
+    _gSources = g.edges().sources().data();
+    _gDests = g.edges().dests().data();
+    _hSources = h.edges().sources().data();
+    _hDests = h.edges().dests().data();
+    _gNodeLabels = columns(g.nodeAttributes());
+    _gEdgeLabels = columns(g.edgeAttributes());
+    _hNodeLabels = queryLabels(h.nodeAttributes());
+    _hEdgeLabels = queryLabels(h.edgeAttributes());
+}
+
+bool MatchCriteria_Labels::appliesTo(const DataGraph &g, const DataGraph &h)
+{
+    for(int nodes=0; nodes<2; nodes++)
+    {
+        const AttributesTable &t1 = nodes ? g.nodeAttributes() : g.edgeAttributes();
+        const AttributesTable &t2 = nodes ? h.nodeAttributes() : h.edgeAttributes();
+        if(t1.numIntColumns() > 0 || t1.numFloatColumns() > 0 ||
+           t2.numIntColumns() > 0 || t2.numFloatColumns() > 0 ||
+           t1.numStringColumns() != t2.numStringColumns())
+            return false;
+        for(int k=0; k<t1.numStringColumns(); k++)
+        {
+            if(!t1.sharesDictionary(k, t2))
+                return false;
+        }
+    }
+    return true;
+}
+
+vector<int> MatchCriteria_Labels::queryLabels(const AttributesTable &t)
+{
+    int numColumns = t.numStringColumns();
+    int numRows = numColumns == 0 ? 0 : t.stringColumn(0).size();
+    vector<int> labels(numRows * numColumns);
+    for(int k=0; k<numColumns; k++)
+    {
+        const vector<StringRestrictions> &restrictions = t.stringRestrictions(k);
+        for(int row=0; row<numRows; row++)
+        {
+            bool any = !restrictions.empty() && restrictions[row].any();
+            labels[row*numColumns + k] = any ? ANY_LABEL : t.stringColumn(k)[row];
+        }
+    }
+    return labels;
+}
+
+vector<const int*> MatchCriteria_Labels::columns(const AttributesTable &t)
+{
+    vector<const int*> labels;
+    for(int k=0; k<t.numStringColumns(); k++)
+        labels.push_back(t.stringColumn(k).data());
+    return labels;
+}
@@ -0,0 +1,114 @@
+/*
+ * File:   MatchCriteria_Labels.h
+ * Author: D3M430
+ *
+ * Created on April 5, 2021, 10:15 AM
+ */
+
+#ifndef MATCHCRITERIA_LABELS_H
+#define	MATCHCRITERIA_LABELS_H
+
+#include "DataGraph.h"
+#include "MatchCriteria_DataGraph.h"
+#include <vector>
+
+/**
+ * The same criteria as MatchCriteria_DataGraph, for data graphs whose only
+ * attributes are strings (such as labels, or no attributes at all) that
+ * share their dictionaries with the query, so every check is comparing
+ * dictionary IDs.  It's made for searching one graph for one query, and
+ * looks up everything it needs from them up front, so the checks don't
+ * make any calls.  Since it's final, and the checks are inline, searches
+ * compiled for it (see SmallQuerySearch) inline them into their loops.
+ */
+class MatchCriteria_Labels final : public MatchCriteria_DataGraph
+{
+public:
+    /**
+     * Sets up the criteria for searching g for h.  Only valid if appliesTo(g, h).
+     * @param g  The graph we are searching.
+     * @param h  The query graph we are looking for.
+     */
+    MatchCriteria_Labels(const DataGraph &g, const DataGraph &h);
+
+    /**
+     * Returns true if MatchCriteria_DataGraph would only compare string
+     * attributes by their IDs when searching g for h.
+     */
+    static bool appliesTo(const DataGraph &g, const DataGraph &h);
+
+    /**
+     * Returns true if there is a match between the graph edge, and the
+     * criteria for the query edge.  The graphs must be the ones the
+     * criteria was made for.
+     * @param g  The graph we are searching.
+     * @param gEdgeIndex  The index of the edge in our search graph we are comparing.
+     * @param h  The query graph we are looking for.
+     * @param hEdgeIndex  The index of the edge in the query graph we are comparing against.
+     * @return  True if the graph edge matches the criteria of the query edge.
+     */
+    virtual bool isEdgeMatch(const Graph &g, int gEdgeIndex, const Graph &h, int hEdgeIndex) const override;
+
+    /**
+     * Returns true if there is a match between the graph node, and the
+     * criteria for the query node.  The graphs must be the ones the
+     * criteria was made for.
+     * @param g  The graph we are searching.
+     * @param gNodeIndex  The index of the node in our search graph we are comparing.
+     * @param h  The query graph we are looking for.
+     * @param hNodeIndex  The index of the node in the query graph we are comparing against.
+     * @return  True if the graph node matches the criteria of the query node.
+     */
+    virtual bool isNodeMatch(const Graph &g, int gNodeIndex, const Graph &h, int hNodeIndex) const override;
+
+private:
+    // Query label that matches any label
+    static const int ANY_LABEL = -2;
+
+    /** Copies the query's labels of each row, with ANY_LABEL where any value is allowed */
+    static std::vector<int> queryLabels(const AttributesTable &t);
+    /** Pointers to each column of labels */
+    static std::vector<const int*> columns(const AttributesTable &t);
+    /** True if the labels in the row of the columns match the query's */
+    static bool doLabelsMatch(const std::vector<const int*> &columns, int row, const int *queryLabels);
+
+    time_t _windowStart, _windowEnd;
+    const time_t *_times;
+    const int *_gSources, *_gDests, *_hSources, *_hDests;
+    // Labels of the graph's nodes and edges, by column
+    std::vector<const int*> _gNodeLabels, _gEdgeLabels;
+    // Labels of the query's nodes and edges, by row (with a label for each column)
+    std::vector<int> _hNodeLabels, _hEdgeLabels;
+};
+
+inline bool MatchCriteria_Labels::doLabelsMatch(const std::vector<const int*> &columns, int row, const int *queryLabels)
+{
+    for(int k=0; k<(int)columns.size(); k++)
+    {
+        // Query strings missing from the dictionary are -1, so match nothing
+        int label = queryLabels[k];
+        if(label != ANY_LABEL && columns[k][row] != label)
+            return false;
+    }
+    return true;
+}
+
+inline bool MatchCriteria_Labels::isEdgeMatch(const Graph &g, int gEdgeIndex, const Graph &h, int hEdgeIndex) const
+{
+    time_t t = _times[gEdgeIndex];
+    if(t < _windowStart || t > _windowEnd)
+        return false;
+    int numColumns = _gEdgeLabels.size();
+    if(!doLabelsMatch(_gEdgeLabels, gEdgeIndex, _hEdgeLabels.data() + hEdgeIndex*numColumns))
+        return false;
+    return isNodeMatch(g, _gSources[gEdgeIndex], h, _hSources[hEdgeIndex]) &&
+           isNodeMatch(g, _gDests[gEdgeIndex], h, _hDests[hEdgeIndex]);
+}
+
+inline bool MatchCriteria_Labels::isNodeMatch(const Graph &g, int gNodeIndex, const Graph &h, int hNodeIndex) const
+{
+    int numColumns = _gNodeLabels.size();
+    return doLabelsMatch(_gNodeLabels, gNodeIndex, _hNodeLabels.data() + hNodeIndex*numColumns);
+}
+
+#endif	/* MATCHCRITERIA_LABELS_H */
@@ -33,3 +33,12 @@ bool MatchCriteria_Weighted::isEdgeMatch(const Graph& g, int gEdgeIndex, const G
     return w >= minW;
 }
 
+
+bool MatchCriteria_Weighted::isSameEdgeCriteria(const Graph &h1, int h1EdgeIndex, const Graph &h2, int h2EdgeIndex) const
+{
+    auto w1 = _minWeights.find(h1EdgeIndex);
+    auto w2 = _minWeights.find(h2EdgeIndex);
+    if(w1 == _minWeights.end() || w2 == _minWeights.end())
+        return w1 == w2;
+    return w1->second == w2->second;
+}
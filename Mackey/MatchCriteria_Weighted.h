@@ -45,6 +45,17 @@ public:
      * @return  True if the graph edge matches the criteria of the query edge.
      */
     virtual bool isNodeMatch(const Graph &g, int gNodeIndex, const Graph &h, int hNodeIndex) const override { return true; }
+    
+    /**
+     * Returns true if both query edges have the same minimum weight (or
+     * neither has one).
+     * @param h1  The first query graph.
+     * @param h1EdgeIndex  The index of the edge in the first query graph.
+     * @param h2  The second query graph.
+     * @param h2EdgeIndex  The index of the edge in the second query graph.
+     * @return  True if the query edges match the same edges.
+     */
+    virtual bool isSameEdgeCriteria(const Graph &h1, int h1EdgeIndex, const Graph &h2, int h2EdgeIndex) const override;
 private:
     std::unordered_map<int,double> _minWeights;
 };
@@ -0,0 +1,19 @@
+#include "MatchOutput.h"
+
+MatchOutput::MatchOutput(const MatchSink &sink, int limit) : _sink(sink), _limit(limit), _numMatches(0), _stopped(limit <= 0)
+{
+}
+
+bool MatchOutput::report(EdgeRange edges)
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    if(stopped())
+        return false;
+    _numMatches++;
+    if(!_sink(edges) || _numMatches >= _limit)
+    {
+        _stopped = true;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,51 @@
+/*
+ * File:   MatchOutput.h
+ * Author: D3M430
+ *
+ * Created on March 29, 2021, 10:15 AM
+ */
+
+#ifndef MATCHOUTPUT_H
+#define	MATCHOUTPUT_H
+
+#include "EdgeRange.h"
+#include <atomic>
+#include <functional>
+#include <limits.h>
+#include <mutex>
+
+/**
+ * Receives each match of a search, as the indexes of the edges in G matched
+ * to each query edge (in query edge order).  The edges are only valid during
+ * the call.  Returns false to stop the search.
+ */
+typedef std::function<bool(EdgeRange)> MatchSink;
+
+/**
+ * Passes the matches of a search to a sink, one at a time (even when
+ * searching on multiple threads), until the sink asks to stop or the limit
+ * is reached.
+ */
+class MatchOutput
+{
+public:
+    MatchOutput(const MatchSink &sink, int limit = INT_MAX);
+    /**
+     * Gives a match to the sink, unless the search has already stopped.
+     * @return  False if the search should stop.
+     */
+    bool report(EdgeRange edges);
+    /** True once no more matches are wanted */
+    bool stopped() const { return _stopped.load(std::memory_order_relaxed); }
+    /** Number of matches given to the sink */
+    long numMatches() const { return _numMatches; }
+
+private:
+    const MatchSink &_sink;
+    int _limit;
+    long _numMatches;
+    std::atomic<bool> _stopped;
+    std::mutex _mutex;
+};
+
+#endif	/* MATCHOUTPUT_H */
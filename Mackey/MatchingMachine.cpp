@@ -0,0 +1,133 @@
+#include "MatchingMachine.h"
+
+using namespace std;
+
+MatchingMachine::MatchingMachine(const Graph &h, const vector<int> &domainSizes)
+{
+    orderNodes(h, domainSizes);
+    orderEdges(h);
+    findBounds();
+}
+
+void MatchingMachine::orderNodes(const Graph &h, const vector<int> &domainSizes)
+{
+    int n = h.numNodes();
+    if(n == 0)
+        throw "The query graph has no nodes to match.";
+
+    // Which query nodes have an edge between them (in either direction)
+    vector<vector<bool>> adjacent(n, vector<bool>(n, false));
+    for(const Edge &edge : h.edges())
+    {
+        if(edge.source() == edge.dest())
+            throw "The TemporalRI search doesn't support self loops in the query graph.";
+        adjacent[edge.source()][edge.dest()] = true;
+        adjacent[edge.dest()][edge.source()] = true;
+    }
+
+    // Nodes that are neither ordered nor neighbors of ordered nodes are OTHER
+    enum NodeSet { OTHER, NEIGHBOR, ORDERED };
+    vector<NodeSet> sets(n, OTHER);
+    vector<int> parentNodes(n, -1);
+    vector<ParentType> parentTypes(n, PARENT_NULL);
+    _nodeStates.assign(n, -1);
+    _stateNodes.clear();
+    for(int si=0; si<n; si++)
+    {
+        // The first node has the highest degree, and the rest are the
+        // neighbors connected to the most ordered nodes.  Ties go to the
+        // node with the fewest candidates.
+        NodeSet candidates = (si == 0) ? OTHER : NEIGHBOR;
+        NodeSet counted = (si == 0) ? OTHER : ORDERED;
+        int bestNode = -1;
+        int highestDeg = -1;
+        for(int u=0; u<n; u++)
+        {
+            if(sets[u] != candidates)
+                continue;
+            int deg = 0;
+            for(int v=0; v<n; v++)
+            {
+                if(adjacent[u][v] && sets[v] == counted)
+                    deg++;
+            }
+            if(deg > highestDeg || (deg == highestDeg && domainSizes[u] < domainSizes[bestNode]))
+            {
+                bestNode = u;
+                highestDeg = deg;
+            }
+        }
+        if(bestNode < 0)
+            throw "The TemporalRI search needs a connected query graph.";
+
+        _stateNodes.push_back(bestNode);
+        _nodeStates[bestNode] = si;
+        sets[bestNode] = ORDERED;
+
+        // Its unordered neighbors can come next
+        for(int v=0; v<n; v++)
+        {
+            if(sets[v] != OTHER || !adjacent[bestNode][v])
+                continue;
+            sets[v] = NEIGHBOR;
+            parentNodes[v] = bestNode;
+            parentTypes[v] = h.hasEdge(bestNode, v) ? PARENT_OUT : PARENT_IN;
+        }
+    }
+
+    _parentStates.resize(n);
+    _parentTypes.resize(n);
+    for(int si=0; si<n; si++)
+    {
+        int u = _stateNodes[si];
+        _parentStates[si] = (parentNodes[u] < 0) ? -1 : _nodeStates[parentNodes[u]];
+        _parentTypes[si] = parentTypes[u];
+    }
+}
+
+void MatchingMachine::orderEdges(const Graph &h)
+{
+    const EdgeList &edges = h.edges();
+    _edgeStates.clear();
+    for(int i=0; i<numNodeStates(); i++)
+    {
+        int source = _stateNodes[i];
+        for(int j=0; j<i; j++)
+        {
+            int dest = _stateNodes[j];
+            if(h.hasEdge(source, dest))
+            {
+                for(int e : h.getEdgeIndexes(source, dest))
+                    _edgeStates.push_back(EdgeState{e, i, j, OUT, edges.times()[e], -1, -1});
+            }
+            if(h.hasEdge(dest, source))
+            {
+                for(int e : h.getEdgeIndexes(dest, source))
+                    _edgeStates.push_back(EdgeState{e, i, j, IN, edges.times()[e], -1, -1});
+            }
+        }
+    }
+}
+
+void MatchingMachine::findBounds()
+{
+    for(int i=0; i<numEdgeStates(); i++)
+    {
+        EdgeState &state = _edgeStates[i];
+        int lower = -1, upper = -1, same = -1;
+        for(int j=0; j<i; j++)
+        {
+            time_t time = _edgeStates[j].time;
+            if(time == state.time)
+                same = j;
+            else if(time < state.time && (lower < 0 || time >= _edgeStates[lower].time))
+                lower = j;
+            else if(time > state.time && (upper < 0 || time <= _edgeStates[upper].time))
+                upper = j;
+        }
+        if(same >= 0)
+            lower = upper = same;
+        state.lowerState = lower;
+        state.upperState = upper;
+    }
+}
@@ -0,0 +1,82 @@
+/*
+ * File:   MatchingMachine.h
+ * Author: D3M430
+ *
+ * Created on March 24, 2021, 10:15 AM
+ */
+
+#ifndef MATCHINGMACHINE_H
+#define	MATCHINGMACHINE_H
+
+#include "Graph.h"
+#include <time.h>
+#include <vector>
+
+/**
+ * The order the TemporalRI search matches the nodes and edges of a query
+ * graph in (ported from src/matching/MatchingMachine.java).  Nodes are
+ * ordered so each one is connected to as many of the nodes before it as
+ * possible, and the edges are ordered by the first node that has both of
+ * their endpoints.  So after the first edge, every edge has at least one
+ * endpoint that's already been matched, and candidates only need to be
+ * found among the edges of that node.
+ */
+class MatchingMachine
+{
+public:
+    /** Direction of a query edge, relative to the state that adds it */
+    enum EdgeType { OUT, IN };
+    /** How a query node is connected to its parent in the ordering */
+    enum ParentType { PARENT_NULL, PARENT_OUT, PARENT_IN };
+
+    /** An edge of the query graph, in matching order */
+    struct EdgeState
+    {
+        // Index of the edge in the query graph
+        int edge;
+        // Node state that adds this edge, and the earlier node state it connects to
+        int sourceState, destState;
+        // OUT if the edge goes from sourceState's node to destState's, IN otherwise
+        EdgeType type;
+        // Time of the edge in the query graph
+        time_t time;
+        // Earlier edge states with the next lower and higher query time
+        // (-1 if none).  If the time was already seen, both are the same
+        // state, which has the same time.
+        int lowerState, upperState;
+    };
+
+    /**
+     * Builds the matching order for the query graph.
+     * @param h  The query graph.  Must be connected, without self loops.
+     * @param domainSizes  Number of nodes in G that each node of h can match to.
+     */
+    MatchingMachine(const Graph &h, const std::vector<int> &domainSizes);
+
+    int numNodeStates() const { return _stateNodes.size(); }
+    int numEdgeStates() const { return _edgeStates.size(); }
+    /** Query node of each node state */
+    int stateNode(int state) const { return _stateNodes[state]; }
+    /** Node state of each query node */
+    int nodeState(int node) const { return _nodeStates[node]; }
+    const EdgeState &edgeState(int state) const { return _edgeStates[state]; }
+    /** Node state of the node's parent (the one that made it a neighbor), or -1 for the first */
+    int parentState(int state) const { return _parentStates[state]; }
+    ParentType parentType(int state) const { return _parentTypes[state]; }
+
+private:
+    /** Orders the nodes */
+    void orderNodes(const Graph &h, const std::vector<int> &domainSizes);
+    /** Orders the edges by the node ordering */
+    void orderEdges(const Graph &h);
+    /** Finds the time bounds of each edge state */
+    void findBounds();
+
+    std::vector<int> _stateNodes, _nodeStates;
+    std::vector<EdgeState> _edgeStates;
+    std::vector<int> _parentStates;
+    std::vector<ParentType> _parentTypes;
+};
+
+#endif	/* MATCHINGMACHINE_H */
+
@@ -0,0 +1,383 @@
+#include "MotifCensus.h"
+#include <algorithm>
+#include <cstring>
+#include <numeric>
+
+using namespace std;
+
+namespace
+{
+    // Edges between nodes 0, 1 and 2, in the order motifs are numbered by.
+    // Edges 2k and 2k+1 are between the same pair of nodes.
+    const int EDGE_SOURCES[6] = { 0, 1, 0, 2, 1, 2 };
+    const int EDGE_DESTS[6] = { 1, 0, 2, 0, 2, 1 };
+    const char *EDGE_NAMES[6] = { "01", "10", "02", "20", "12", "21" };
+
+    /** Motif of three edges around node 0, each going out to (or in from) the given neighbor */
+    int starMotif(int n1, int d1, int n2, int d2, int n3, int d3)
+    {
+        int neighbors[3] = { n1, n2, n3 };
+        int directions[3] = { d1, d2, d3 };
+        int sources[3], dests[3];
+        for(int i=0; i<3; i++)
+        {
+            // Direction 0 is out of the center
+            sources[i] = directions[i] == 0 ? 0 : neighbors[i];
+            dests[i] = directions[i] == 0 ? neighbors[i] : 0;
+        }
+        return MotifCensus::motifOf(sources, dests);
+    }
+}
+
+MotifCensus::MotifCensus(const Graph &g, time_t delta) : _delta(delta), _counts(NUM_MOTIFS, 0)
+{
+    countStars(g);
+    countTriangles(g);
+}
+
+string MotifCensus::name(int motif)
+{
+    return string("01-") + EDGE_NAMES[motif/6] + "-" + EDGE_NAMES[motif%6];
+}
+
+int MotifCensus::motifOf(const int sources[3], const int dests[3])
+{
+    // Number the nodes in the order they appear
+    int nodes[3];
+    int numNodes = 0;
+    int edges[3];
+    for(int i=0; i<3; i++)
+    {
+        int ends[2] = { sources[i], dests[i] };
+        for(int k=0; k<2; k++)
+        {
+            int id = find(nodes, nodes + numNodes, ends[k]) - nodes;
+            if(id == numNodes)
+            {
+                if(numNodes == 3)
+                    return -1;
+                nodes[numNodes++] = ends[k];
+            }
+            ends[k] = id;
+        }
+        edges[i] = -1;
+        for(int e=0; e<6; e++)
+        {
+            if(EDGE_SOURCES[e] == ends[0] && EDGE_DESTS[e] == ends[1])
+                edges[i] = e;
+        }
+        if(edges[i] < 0)
+            return -1;
+    }
+    return edges[1]*6 + edges[2];
+}
+
+void MotifCensus::countStars(const Graph &g)
+{
+    // List the edges around each node in one pass over the edges, which
+    // keeps them in time order
+    const EdgeList &edges = g.edges();
+    const int *sources = edges.sources().data();
+    const int *dests = edges.dests().data();
+    const time_t *times = edges.times().data();
+    int n = g.numNodes();
+    int m = g.numEdges();
+    _offsets.assign(n+1, 0);
+    for(int e=0; e<m; e++)
+    {
+        if(sources[e] == dests[e])
+            continue;
+        _offsets[sources[e]+1]++;
+        _offsets[dests[e]+1]++;
+    }
+    partial_sum(_offsets.begin(), _offsets.end(), _offsets.begin());
+    _neighbors.resize(_offsets[n]);
+    _directions.resize(_offsets[n]);
+    _times.resize(_offsets[n]);
+    vector<int> next(_offsets.begin(), _offsets.end() - 1);
+    for(int e=0; e<m; e++)
+    {
+        int u = sources[e], v = dests[e];
+        if(u == v)
+            continue;
+        _neighbors[next[u]] = v;
+        _directions[next[u]] = OUT;
+        _times[next[u]++] = times[e];
+        _neighbors[next[v]] = u;
+        _directions[next[v]] = IN;
+        _times[next[v]++] = times[e];
+    }
+
+    memset(_preStars, 0, sizeof(_preStars));
+    memset(_midStars, 0, sizeof(_midStars));
+    memset(_postStars, 0, sizeof(_postStars));
+    memset(_pairs, 0, sizeof(_pairs));
+    _neighborCounts.assign(n, NeighborCounts());
+    _starts.resize(2*_neighbors.size());
+    for(int u=0; u<n; u++)
+    {
+        countAround(u, _offsets[u], _offsets[u+1] - _offsets[u], false);
+        countAround(u, _offsets[u], _offsets[u+1] - _offsets[u], true);
+    }
+
+    // The center is node 0, the neighbor on two of the edges is node 1,
+    // and the other neighbor is node 2
+    for(int d1=0; d1<2; d1++)
+    {
+        for(int d2=0; d2<2; d2++)
+        {
+            for(int d3=0; d3<2; d3++)
+            {
+                _counts[starMotif(2, d1, 1, d2, 1, d3)] += _preStars[d1][d2][d3];
+                _counts[starMotif(1, d1, 2, d2, 1, d3)] += _midStars[d1][d2][d3];
+                _counts[starMotif(1, d1, 1, d2, 2, d3)] += _postStars[d1][d2][d3];
+                _counts[starMotif(1, d1, 1, d2, 1, d3)] += _pairs[d1][d2][d3];
+            }
+        }
+    }
+}
+
+void MotifCensus::countAround(int center, int first, int size, bool backward)
+{
+    const int *neighbors = _neighbors.data() + first;
+    const char *directions = _directions.data() + first;
+    const time_t *times = _times.data() + first;
+    long *starts = _starts.data() + 2*first;
+    // Going backward, the i-th edge we pass is from the end, and times go
+    // up as they go back
+    auto at = [&](int i) { return backward ? size-1 - i : i; };
+    auto timeOf = [&](int i) { return backward ? -times[at(i)] : times[at(i)]; };
+
+    // Pairs of edges in the window with the same neighbor (by their
+    // directions), and the number of edges passed so far in each direction
+    long pairs[2][2] = { { 0, 0 }, { 0, 0 } };
+    long numEdges[2] = { 0, 0 };
+    int oldest = 0;
+    for(int begin=0; begin<size; )
+    {
+        // Edges at the same time can't come before or after each other, so
+        // take them all at once
+        time_t t = timeOf(begin);
+        int end = begin + 1;
+        while(end < size && timeOf(end) == t)
+            end++;
+
+        // Drop the edges that are more than delta from these out of the window
+        while(oldest < begin && timeOf(oldest) < t - _delta)
+        {
+            int dropEnd = oldest + 1;
+            while(dropEnd < begin && timeOf(dropEnd) == timeOf(oldest))
+                dropEnd++;
+            for(int i=oldest; i<dropEnd; i++)
+                _neighborCounts[neighbors[at(i)]].edges[(int)directions[at(i)]]--;
+            // Each one takes with it the pairs it starts (with the edges
+            // still in the window, which all come after it)
+            for(int i=oldest; i<dropEnd; i++)
+            {
+                NeighborCounts &counts = _neighborCounts[neighbors[at(i)]];
+                int d1 = directions[at(i)];
+                for(int d2=0; d2<2; d2++)
+                {
+                    counts.pairs[d1][d2] -= counts.edges[d2];
+                    pairs[d1][d2] -= counts.edges[d2];
+                    counts.startSums[d1][d2] -= starts[2*at(i) + d2];
+                }
+            }
+            oldest = dropEnd;
+        }
+
+        // Count the motifs that end with each of these edges
+        for(int k=begin; k<end; k++)
+        {
+            const NeighborCounts &counts = _neighborCounts[neighbors[at(k)]];
+            int d3 = directions[at(k)];
+            for(int d1=0; d1<2; d1++)
+            {
+                for(int d2=0; d2<2; d2++)
+                {
+                    // Pairs with another neighbor, then this one
+                    long otherPairs = pairs[d1][d2] - counts.pairs[d1][d2];
+                    if(backward)
+                    {
+                        // Going back, this edge is the first one
+                        _preStars[d3][d2][d1] += otherPairs;
+                        continue;
+                    }
+                    _postStars[d1][d2][d3] += otherPairs;
+                    // Pairs starting with this neighbor, then another one:
+                    // every edge since each of the neighbor's edges, less
+                    // the ones with the same neighbor
+                    _midStars[d1][d2][d3] += counts.edges[d1]*numEdges[d2] - counts.startSums[d1][d2] - counts.pairs[d1][d2];
+                    // Motifs on 2 nodes are counted from the lower one
+                    if(center < neighbors[at(k)])
+                        _pairs[d1][d2][d3] += counts.pairs[d1][d2];
+                }
+            }
+        }
+
+        // Add them to the window
+        for(int k=begin; k<end; k++)
+        {
+            NeighborCounts &counts = _neighborCounts[neighbors[at(k)]];
+            int d2 = directions[at(k)];
+            for(int d1=0; d1<2; d1++)
+            {
+                counts.pairs[d1][d2] += counts.edges[d1];
+                pairs[d1][d2] += counts.edges[d1];
+            }
+        }
+        for(int k=begin; k<end; k++)
+        {
+            _neighborCounts[neighbors[at(k)]].edges[(int)directions[at(k)]]++;
+            numEdges[(int)directions[at(k)]]++;
+        }
+        for(int k=begin; k<end; k++)
+        {
+            NeighborCounts &counts = _neighborCounts[neighbors[at(k)]];
+            int d1 = directions[at(k)];
+            for(int d2=0; d2<2; d2++)
+            {
+                starts[2*at(k) + d2] = numEdges[d2];
+                counts.startSums[d1][d2] += numEdges[d2];
+            }
+        }
+        begin = end;
+    }
+
+    // Leave the counts clear for the next node
+    for(int i=0; i<size; i++)
+        _neighborCounts[neighbors[i]] = NeighborCounts();
+}
+
+void MotifCensus::countTriangles(const Graph &g)
+{
+    // Neighbors of each node (in either direction), ranked by how many
+    // there are.  Each triangle is found once, from its lowest ranked node.
+    int n = g.numNodes();
+    vector<int> degrees(n);
+    vector<vector<int>> later(n);
+    for(int u=0; u<n; u++)
+    {
+        vector<int> &neighbors = later[u];
+        neighbors.assign(_neighbors.begin() + _offsets[u], _neighbors.begin() + _offsets[u+1]);
+        sort(neighbors.begin(), neighbors.end());
+        neighbors.erase(unique(neighbors.begin(), neighbors.end()), neighbors.end());
+        degrees[u] = neighbors.size();
+    }
+    auto before = [&](int u, int v) { return degrees[u] < degrees[v] || (degrees[u] == degrees[v] && u < v); };
+    for(int u=0; u<n; u++)
+        later[u].erase(remove_if(later[u].begin(), later[u].end(), [&](int v) { return before(v, u); }), later[u].end());
+
+    memset(_triangles, 0, sizeof(_triangles));
+    vector<char> marked(n, 0);
+    for(int u=0; u<n; u++)
+    {
+        for(int v : later[u])
+            marked[v] = 1;
+        for(int v : later[u])
+        {
+            for(int w : later[v])
+            {
+                if(marked[w])
+                    countTriangle(g, u, v, w);
+            }
+        }
+        for(int v : later[u])
+            marked[v] = 0;
+    }
+
+    for(int e1=0; e1<6; e1++)
+    {
+        for(int e2=0; e2<6; e2++)
+        {
+            for(int e3=0; e3<6; e3++)
+            {
+                if(_triangles[e1][e2][e3] == 0)
+                    continue;
+                int sources[3] = { EDGE_SOURCES[e1], EDGE_SOURCES[e2], EDGE_SOURCES[e3] };
+                int dests[3] = { EDGE_DESTS[e1], EDGE_DESTS[e2], EDGE_DESTS[e3] };
+                _counts[motifOf(sources, dests)] += _triangles[e1][e2][e3];
+            }
+        }
+    }
+}
+
+void MotifCensus::countTriangle(const Graph &g, int x, int y, int z)
+{
+    // Gather the edges between each pair, as (edge, kind of edge), where
+    // the kinds are the edges of EDGE_SOURCES and EDGE_DESTS with x, y and z
+    // as nodes 0, 1 and 2.  In edge order, they're in time order.
+    const time_t *times = g.edges().times().data();
+    int nodes[3] = { x, y, z };
+    vector<pair<int, int>> &edges = _triangleEdges;
+    edges.clear();
+    for(int kind=0; kind<6; kind++)
+    {
+        int u = nodes[EDGE_SOURCES[kind]], v = nodes[EDGE_DESTS[kind]];
+        if(!g.hasEdge(u, v))
+            continue;
+        for(int e : g.getEdgeIndexes(u, v))
+            edges.push_back(make_pair(e, kind));
+    }
+    sort(edges.begin(), edges.end());
+
+    // Edges of each kind in the window, and pairs of them between different
+    // pairs of nodes (the second after the first)
+    long singles[6] = { 0 };
+    long pairs[6][6] = { { 0 } };
+    int size = edges.size();
+    int oldest = 0;
+    for(int begin=0; begin<size; )
+    {
+        time_t t = times[edges[begin].first];
+        int end = begin + 1;
+        while(end < size && times[edges[end].first] == t)
+            end++;
+
+        while(oldest < begin && times[edges[oldest].first] < t - _delta)
+        {
+            int dropEnd = oldest + 1;
+            while(dropEnd < begin && times[edges[dropEnd].first] == times[edges[oldest].first])
+                dropEnd++;
+            for(int i=oldest; i<dropEnd; i++)
+                singles[edges[i].second]--;
+            for(int i=oldest; i<dropEnd; i++)
+            {
+                int k1 = edges[i].second;
+                for(int k2=0; k2<6; k2++)
+                {
+                    if(k2/2 != k1/2)
+                        pairs[k1][k2] -= singles[k2];
+                }
+            }
+            oldest = dropEnd;
+        }
+
+        // Count the triangles that end with each of these edges
+        for(int i=begin; i<end; i++)
+        {
+            int k3 = edges[i].second;
+            for(int k1=0; k1<6; k1++)
+            {
+                for(int k2=0; k2<6; k2++)
+                {
+                    if(k1/2 != k2/2 && k1/2 != k3/2 && k2/2 != k3/2)
+                        _triangles[k1][k2][k3] += pairs[k1][k2];
+                }
+            }
+        }
+
+        for(int i=begin; i<end; i++)
+        {
+            int k2 = edges[i].second;
+            for(int k1=0; k1<6; k1++)
+            {
+                if(k1/2 != k2/2)
+                    pairs[k1][k2] += singles[k1];
+            }
+        }
+        for(int i=begin; i<end; i++)
+            singles[edges[i].second]++;
+        begin = end;
+    }
+}
@@ -0,0 +1,110 @@
+/*
+ * File:   MotifCensus.h
+ * Author: D3M430
+ *
+ * Created on April 16, 2021, 9:40 AM
+ */
+
+#ifndef MOTIFCENSUS_H
+#define	MOTIFCENSUS_H
+
+#include "Graph.h"
+#include <string>
+#include <time.h>
+#include <utility>
+#include <vector>
+
+/**
+ * Counts every temporal motif with 3 edges on 2 or 3 nodes (the 36 motifs
+ * of the usual census) for one delta, without searching for any of them.
+ * A motif's edges happen at strictly increasing times, all within delta of
+ * the first, so each count is the same as GraphSearch::findOrderedSubgraphs
+ * finds for a query with edge times 1, 2 and 3 (and no other criteria).
+ *
+ * Motifs are numbered by their second and third edges, with the nodes
+ * numbered in the order they appear (so the first edge is always 0->1).
+ * Motif 6*i + j has second edge i and third edge j, from 0->1, 1->0, 0->2,
+ * 2->0, 1->2 and 2->1.
+ *
+ * The counts come from sliding windows over time-sorted lists of edges,
+ * keeping counts of the single edges and pairs of edges in the window:
+ * around each node, with counts for each neighbor (for the motifs on 2
+ * nodes, and the stars, where one node is on every edge), and along the
+ * pairs of nodes of each triangle (for the rest).
+ */
+class MotifCensus
+{
+public:
+    /** Number of motifs counted */
+    static const int NUM_MOTIFS = 36;
+
+    /**
+     * Counts the motifs in g.  Self loops are never part of a motif.
+     * @param g  The graph to count in.
+     * @param delta  The max time duration allowed between a motif's first and last edges.
+     */
+    MotifCensus(const Graph &g, time_t delta);
+    time_t delta() const { return _delta; }
+    /** Number of times each motif happens in g */
+    const std::vector<long> &counts() const { return _counts; }
+    /** Name of the motif, listing its edges (such as "01-10-02") */
+    static std::string name(int motif);
+    /**
+     * Motif made of the three edges (in time order), with the nodes
+     * given by any ids, or -1 if they aren't one (say, with a self loop,
+     * or more than 3 nodes).
+     */
+    static int motifOf(const int sources[3], const int dests[3]);
+
+private:
+    // Directions of the edges around a node
+    enum Direction { OUT, IN };
+
+    /** Counts of the edges between a center and one of its neighbors in the window */
+    struct NeighborCounts
+    {
+        // Edges in each direction
+        long edges[2];
+        // Pairs of edges (the second after the first), by their directions
+        long pairs[2][2];
+        // Sums over the edges in each direction of how many edges in each
+        // direction the center had when they were added
+        long startSums[2][2];
+    };
+
+    /** Counts the motifs on 2 nodes, and the stars, around every node */
+    void countStars(const Graph &g);
+    /**
+     * Passes a window over the edges around a node, counting the stars and
+     * motifs on 2 nodes that end at each edge.  Backward, it only counts
+     * the stars whose first edge has a different neighbor, going back in time.
+     * @param center  The node.
+     * @param first  First of the edges around it.
+     * @param size  Number of edges around it.
+     */
+    void countAround(int center, int first, int size, bool backward);
+    /** Counts the motifs on 3 nodes that have an edge between every pair of them */
+    void countTriangles(const Graph &g);
+    /** Counts the triangle motifs on the edges between the three nodes */
+    void countTriangle(const Graph &g, int x, int y, int z);
+
+    time_t _delta;
+    std::vector<long> _counts;
+    // Edges around each node (with no self loops), in time order: those of
+    // node u are from _offsets[u] up to _offsets[u+1]
+    std::vector<int> _offsets, _neighbors;
+    std::vector<char> _directions;
+    std::vector<time_t> _times;
+    // Counts for each neighbor of the node we're counting around
+    std::vector<NeighborCounts> _neighborCounts;
+    // Number of edges in each direction the center had when each was added
+    std::vector<long> _starts;
+    // Counts of each kind of star by their directions, and of motifs on 2 nodes
+    long _preStars[2][2][2], _midStars[2][2][2], _postStars[2][2][2], _pairs[2][2][2];
+    // Counts of triangles by their edges (see countTriangle)
+    long _triangles[6][6][6];
+    // Edges of the triangle being counted
+    std::vector<std::pair<int, int>> _triangleEdges;
+};
+
+#endif	/* MOTIFCENSUS_H */
@@ -0,0 +1,277 @@
+#include "MultiQuerySearch.h"
+#include "WorkStealingPool.h"
+#include <algorithm>
+#include <thread>
+
+using namespace std;
+
+vector<vector<long>> MultiQuerySearch::countOrderedSubgraphs(const Graph &g, const vector<const Graph*> &queries,
+    const MatchCriteria &criteria, const vector<time_t> &deltas)
+{
+    _g = &g;
+    _queries = &queries;
+    _criteria = &criteria;
+    _counts.assign(queries.size(), DeltaCounts(deltas));
+    _delta = deltas.empty() ? 0 : _counts[0].maxDelta();
+
+    // Make sure the edges (and the node edge lists) are in chronological order
+    g.edges();
+    for(const Graph *h : queries)
+        h->edges();
+
+    buildSteps();
+    resetSearchState();
+    if(!deltas.empty())
+    {
+        if(_numThreads > 1)
+            countOrderedSubgraphsParallel();
+        else
+            searchFirst(0, g.numEdges());
+    }
+
+    vector<vector<long>> counts;
+    for(const DeltaCounts &queryCounts : _counts)
+        counts.push_back(queryCounts.counts());
+    return counts;
+}
+
+void MultiQuerySearch::setNumThreads(int numThreads)
+{
+    if(numThreads < 0)
+        throw "The number of search threads can't be negative.";
+    if(numThreads == 0)
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+    _numThreads = numThreads;
+}
+
+void MultiQuerySearch::buildSteps()
+{
+    _steps.assign(1, Step());
+    _numQueryNodes = 0;
+    for(int q=0; q<(int)_queries->size(); q++)
+    {
+        const Graph &h = *(*_queries)[q];
+        const EdgeList &edges = h.edges();
+        if(h.numEdges() == 0)
+            continue;
+
+        // Number the nodes by the order they first appear, so queries that
+        // start the same way number those nodes the same way
+        vector<int> nodeIds(h.numNodes(), -1);
+        int numNodes = 0;
+        int step = 0;
+        for(int h_i=0; h_i<h.numEdges(); h_i++)
+        {
+            int firstNew = numNodes;
+            int h_u = edges.sources()[h_i];
+            int h_v = edges.dests()[h_i];
+            if(nodeIds[h_u] < 0)
+                nodeIds[h_u] = numNodes++;
+            if(nodeIds[h_v] < 0)
+                nodeIds[h_v] = numNodes++;
+            bool sameTime = h_i > 0 && edges.times()[h_i] == edges.times()[h_i-1];
+            step = addStep(step, q, h_i, nodeIds[h_u], nodeIds[h_v], sameTime, firstNew);
+        }
+        _steps[step].ends.push_back(q);
+        _numQueryNodes = std::max(_numQueryNodes, numNodes);
+    }
+}
+
+int MultiQuerySearch::addStep(int parent, int query, int edge, int source, int dest, bool sameTime, int firstNew)
+{
+    const Graph &h = *(*_queries)[query];
+    int h_u = h.edges().sources()[edge];
+    int h_v = h.edges().dests()[edge];
+    for(int si : _steps[parent].next)
+    {
+        const Step &step = _steps[si];
+        if(step.source != source || step.dest != dest || step.sameTime != sameTime)
+            continue;
+        const Graph &stepQuery = *(*_queries)[step.query];
+        if(!_criteria->isSameEdgeCriteria(stepQuery, step.edge, h, edge))
+            continue;
+        // Nodes from earlier steps were already compared there
+        if(source >= firstNew && !_criteria->isSameNodeCriteria(stepQuery, stepQuery.edges().sources()[step.edge], h, h_u))
+            continue;
+        if(dest >= firstNew && !_criteria->isSameNodeCriteria(stepQuery, stepQuery.edges().dests()[step.edge], h, h_v))
+            continue;
+        return si;
+    }
+
+    Step step;
+    step.query = query;
+    step.edge = edge;
+    step.source = source;
+    step.dest = dest;
+    step.sameTime = sameTime;
+    _steps.push_back(step);
+    _steps[parent].next.push_back(_steps.size() - 1);
+    return _steps.size() - 1;
+}
+
+void MultiQuerySearch::resetSearchState()
+{
+    int n = _g->numNodes();
+    _h2gNodes.assign(_numQueryNodes, -1);
+    _g2hNodes.assign(n, -1);
+    _numMatchEdgesForNode.assign(n, 0);
+    _matchEdges.clear();
+}
+
+void MultiQuerySearch::countOrderedSubgraphsParallel()
+{
+    // Nothing can be built on demand while the threads are searching
+    if(!_g->frozen())
+        throw "The graphs must be frozen to search them from multiple threads.";
+    for(const Graph *h : *_queries)
+    {
+        if(!h->frozen())
+            throw "The graphs must be frozen to search them from multiple threads.";
+    }
+
+    // Split the edges matched to the first steps into many more chunks than
+    // threads, since busy periods will have far more matches than others
+    struct EdgeChunk
+    {
+        int begin, end;
+    };
+    const int CHUNKS_PER_THREAD = 64;
+    int m = _g->numEdges();
+    int chunkSize = std::max(1, m / (_numThreads * CHUNKS_PER_THREAD));
+    WorkStealingPool<EdgeChunk> pool(_numThreads);
+    int chunk = 0;
+    for(int begin=0; begin<m; begin+=chunkSize, chunk++)
+        pool.push(chunk % _numThreads, EdgeChunk{begin, std::min(m, begin+chunkSize)});
+
+    vector<vector<DeltaCounts>> threadCounts(_numThreads);
+    pool.run([&](int worker)
+    {
+        // Each thread gets its own search state and counts
+        MultiQuerySearch search = *this;
+        for(DeltaCounts &counts : search._counts)
+            counts = counts.empty();
+        EdgeChunk range;
+        while(pool.pop(worker, range))
+        {
+            search.searchFirst(range.begin, range.end);
+            pool.finish();
+        }
+        threadCounts[worker] = search._counts;
+    });
+
+    for(const vector<DeltaCounts> &counts : threadCounts)
+    {
+        for(int q=0; q<(int)counts.size(); q++)
+            _counts[q].merge(counts[q]);
+    }
+}
+
+void MultiQuerySearch::searchFirst(int begin, int end)
+{
+    for(int si : _steps[0].next)
+    {
+        for(int g_e=begin; g_e<end; g_e++)
+            tryEdge(si, g_e);
+    }
+}
+
+void MultiQuerySearch::searchNext(int step)
+{
+    const EdgeList &edges = _g->edges();
+    const time_t *times = edges.times().data();
+    time_t prevTime = times[_matchEdges.back()];
+    time_t endTime = times[_matchEdges.front()] + _delta;
+
+    for(int si : _steps[step].next)
+    {
+        const Step &next = _steps[si];
+
+        // The edge happens at the same time as the last one, or after it
+        // (but within delta of the first)
+        time_t minTime = next.sameTime ? prevTime : prevTime + 1;
+        time_t maxTime = next.sameTime ? prevTime : endTime;
+        if(minTime > maxTime)
+            continue;
+
+        // Search the edges of the ends that are already matched, if any
+        int g_u = _h2gNodes[next.source];
+        int g_v = _h2gNodes[next.dest];
+        if(g_u >= 0 && g_v >= 0)
+        {
+            if(!_g->hasEdge(g_u, g_v))
+                continue;
+            EdgeRange candidates = _g->getEdgeIndexes(g_u, g_v);
+            const int *it = std::lower_bound(candidates.begin(), candidates.end(), minTime,
+                [times](int g_e, time_t t) { return times[g_e] < t; });
+            for(; it != candidates.end() && times[*it] <= maxTime; ++it)
+                tryEdge(si, *it);
+        }
+        else if(g_u >= 0 || g_v >= 0)
+        {
+            const Node &node = _g->nodes()[g_u >= 0 ? g_u : g_v];
+            const Column<int> &nodeEdges = (g_u >= 0) ? node.outEdges() : node.inEdges();
+            const Column<time_t> &nodeTimes = (g_u >= 0) ? node.outEdgeTimes() : node.inEdgeTimes();
+            int numNodeEdges = nodeEdges.size();
+            int k = std::lower_bound(nodeTimes.begin(), nodeTimes.end(), minTime) - nodeTimes.begin();
+            for(; k<numNodeEdges && nodeTimes[k] <= maxTime; k++)
+                tryEdge(si, nodeEdges[k]);
+        }
+        else
+        {
+            int m = _g->numEdges();
+            int g_e = std::lower_bound(times, times + m, minTime) - times;
+            for(; g_e<m && times[g_e] <= maxTime; g_e++)
+                tryEdge(si, g_e);
+        }
+    }
+}
+
+void MultiQuerySearch::tryEdge(int si, int g_e)
+{
+    const Step &step = _steps[si];
+    const EdgeList &edges = _g->edges();
+    int g_u = edges.sources()[g_e];
+    int g_v = edges.dests()[g_e];
+
+    // Self loops only match self loops
+    if((step.source == step.dest) != (g_u == g_v))
+        return;
+    // Each end must already be matched to the node, or both must be unmatched
+    if(_h2gNodes[step.source] != g_u && (_h2gNodes[step.source] >= 0 || _g2hNodes[g_u] >= 0))
+        return;
+    if(_h2gNodes[step.dest] != g_v && (_h2gNodes[step.dest] >= 0 || _g2hNodes[g_v] >= 0))
+        return;
+    if(!_criteria->isEdgeMatch(*_g, g_e, *(*_queries)[step.query], step.edge))
+        return;
+
+    _h2gNodes[step.source] = g_u;
+    _h2gNodes[step.dest] = g_v;
+    _g2hNodes[g_u] = step.source;
+    _g2hNodes[g_v] = step.dest;
+    _numMatchEdgesForNode[g_u]++;
+    _numMatchEdgesForNode[g_v]++;
+    _matchEdges.push_back(g_e);
+
+    if(!step.ends.empty())
+    {
+        const time_t *times = edges.times().data();
+        time_t span = times[g_e] - times[_matchEdges.front()];
+        for(int q : step.ends)
+            _counts[q].add(span);
+    }
+    if(!step.next.empty())
+        searchNext(si);
+
+    _matchEdges.pop_back();
+    // Unmatch the nodes no other matched edge uses
+    if(--_numMatchEdgesForNode[g_u] == 0)
+    {
+        _h2gNodes[_g2hNodes[g_u]] = -1;
+        _g2hNodes[g_u] = -1;
+    }
+    if(--_numMatchEdgesForNode[g_v] == 0)
+    {
+        _h2gNodes[_g2hNodes[g_v]] = -1;
+        _g2hNodes[g_v] = -1;
+    }
+}
@@ -0,0 +1,100 @@
+/*
+ * File:   MultiQuerySearch.h
+ * Author: D3M430
+ *
+ * Created on March 31, 2021, 10:40 AM
+ */
+
+#ifndef MULTIQUERYSEARCH_H
+#define	MULTIQUERYSEARCH_H
+
+#include "DeltaCounts.h"
+#include "Graph.h"
+#include "MatchCriteria.h"
+#include <time.h>
+#include <vector>
+
+/**
+ * Ordered subgraph search for many query graphs at once.  The queries are
+ * merged into a tree of steps, where each step matches one query edge
+ * (in time order, like GraphSearch::findOrderedSubgraphs).  Queries that
+ * start with the same edges (the same pattern of nodes, criteria and time
+ * order) share the steps for those edges, so their matches are only
+ * searched for once, and the search only branches where the queries differ.
+ */
+class MultiQuerySearch
+{
+public:
+    /**
+     * Counts the subgraphs of g that match each query graph, with the edges
+     * in the same time order, for each delta value.
+     * @param g  The directed graph to search on.
+     * @param queries  The directed query graphs we are trying to match.
+     * @param criteria  Polymorphic class specifies whether or not two given edges match the query criteria.
+     * @param deltas  The max time durations allowed between edge matches.
+     * @return  Number of subgraphs that match each query, within each delta.
+     */
+    std::vector<std::vector<long>> countOrderedSubgraphs(const Graph &g, const std::vector<const Graph*> &queries,
+        const MatchCriteria &criteria, const std::vector<time_t> &deltas);
+
+    /**
+     * Sets how many threads the search uses.  With more than one, the
+     * graphs must be frozen, since they're searched from every thread.
+     * @param numThreads  Number of threads (0 for one per core).
+     */
+    void setNumThreads(int numThreads);
+    int numThreads() const { return _numThreads; }
+
+    /** Number of steps the queries of the last search were merged into (at
+     * most their total number of edges) */
+    int numSteps() const { return _steps.empty() ? 0 : _steps.size() - 1; }
+
+private:
+    /** One query edge to match, shared by every query that starts the same way */
+    struct Step
+    {
+        // Query (and its edge) the step was first made for
+        int query, edge;
+        // Ends of the edge, numbered by the order they first appear in the query's edges
+        int source, dest;
+        // True if the edge happens at the same time as the previous one (otherwise it's later)
+        bool sameTime;
+        // Steps that can follow this one, and the queries that end with it
+        std::vector<int> next, ends;
+    };
+
+    /** Merges the queries into the tree of steps (starting from an empty root step) */
+    void buildSteps();
+    /** Finds the step after parent that matches the query edge, adding it if there isn't one.
+     * Nodes numbered from firstNew on aren't in any of the steps before it. */
+    int addStep(int parent, int query, int edge, int source, int dest, bool sameTime, int firstNew);
+    /** Sizes the search state for the current graphs */
+    void resetSearchState();
+    /** Searches on multiple threads, splitting up the edges matched to the first steps */
+    void countOrderedSubgraphsParallel();
+    /** Matches the first steps to edges of G from begin up to end, and everything after them */
+    void searchFirst(int begin, int end);
+    /** Matches the steps after the given one (the last step matched) */
+    void searchNext(int step);
+    /** Matches step si to edge g_e of G (if it can be) and searches the steps after it */
+    void tryEdge(int si, int g_e);
+
+    const Graph *_g;
+    const std::vector<const Graph*> *_queries;
+    const MatchCriteria *_criteria;
+    time_t _delta;
+    int _numThreads = 1;
+    std::vector<Step> _steps;
+    // Most nodes any of the queries have (by the numbering of the steps)
+    int _numQueryNodes;
+    // Matches of each query, by their time span
+    std::vector<DeltaCounts> _counts;
+    // Node in G matched to each query node (by the numbering of the steps), and the other way around
+    std::vector<int> _h2gNodes, _g2hNodes;
+    // Number of matched edges using each node in G
+    std::vector<int> _numMatchEdgesForNode;
+    // Edges in G matched to the steps so far
+    std::vector<int> _matchEdges;
+};
+
+#endif	/* MULTIQUERYSEARCH_H */
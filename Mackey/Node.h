@@ -8,29 +8,40 @@
 #ifndef NODE_H
 #define	NODE_H
 
-#include <vector>
+#include "Column.h"
+#include <time.h>
 
 /**
  * Basic node in our graph.  Contains a list of out going and incoming
- * edges in the order they occurred.
+ * edges in the order they occurred, along with the time of each of those
+ * edges, so the lists can be searched by time without looking up each edge.
  */
 class Node
 {
 public:    
     /** All edges from or to this node, in chronological order */
-    std::vector<int> &edges() { return _edges; }
+    Column<int> &edges() { return _edges; }
     /** Outgoing edges, in chronological order */
-    std::vector<int> &outEdges() { return _outEdges; }
+    Column<int> &outEdges() { return _outEdges; }
     /** Ingoing edges, in chronological order */
-    std::vector<int> &inEdges() { return _inEdges; }
+    Column<int> &inEdges() { return _inEdges; }
     /** All edges from or to this node, in chronological order */
-    const std::vector<int> &edges() const { return _edges; }
+    const Column<int> &edges() const { return _edges; }
     /** Outgoing edges, in chronological order */
-    const std::vector<int> &outEdges() const { return _outEdges; }
+    const Column<int> &outEdges() const { return _outEdges; }
     /** Ingoing edges, in chronological order */
-    const std::vector<int> &inEdges() const { return _inEdges; }
+    const Column<int> &inEdges() const { return _inEdges; }
+    /** Time of each outgoing edge (parallel to outEdges) */
+    Column<time_t> &outEdgeTimes() { return _outEdgeTimes; }
+    /** Time of each ingoing edge (parallel to inEdges) */
+    Column<time_t> &inEdgeTimes() { return _inEdgeTimes; }
+    /** Time of each outgoing edge (parallel to outEdges) */
+    const Column<time_t> &outEdgeTimes() const { return _outEdgeTimes; }
+    /** Time of each ingoing edge (parallel to inEdges) */
+    const Column<time_t> &inEdgeTimes() const { return _inEdgeTimes; }
 private:
-    std::vector<int> _edges, _outEdges, _inEdges;
+    Column<int> _edges, _outEdges, _inEdges;
+    Column<time_t> _outEdgeTimes, _inEdgeTimes;
 };
 
 #endif	/* NODE_H */
@@ -0,0 +1,402 @@
+#include "NodeDomains.h"
+#include <algorithm>
+#include <tuple>
+
+using namespace std;
+
+void NodeDomains::compute(const Graph &g, const Graph &h, const MatchCriteria &criteria, time_t delta, bool ordered)
+{
+    // Make sure the edges (and the node edge lists) are in chronological order
+    g.edges();
+    h.edges();
+
+    int n = g.numNodes();
+    int k = h.numNodes();
+    _bits.assign(k, vector<uint64_t>((n + 63) / 64, 0));
+    _nodes.assign(k, vector<int>());
+
+    // What each query node needs, and the most of each kind any of them need
+    vector<Signature> querySigs(k);
+    Signature limits;
+    for(int h_u=0; h_u<k; h_u++)
+    {
+        querySigs[h_u] = querySignature(h, h_u);
+        if(!ordered)
+        {
+            querySigs[h_u].numIn = 0;
+            querySigs[h_u].numOut = 0;
+        }
+        for(int f=0; f<NUM_FLOW_TYPES; f++)
+        {
+            limits.flows2[f] = std::max(limits.flows2[f], querySigs[h_u].flows2[f]);
+            limits.flows3[f] = std::max(limits.flows3[f], querySigs[h_u].flows3[f]);
+        }
+    }
+    // Flows only mean something if the edges have to be in the same order
+    bool useFlows = ordered && limits.hasFlows();
+
+    vector<Signature> sigs;
+    countDegrees(g, sigs);
+    vector<int> candidates;
+    for(int g_u=0; g_u<n; g_u++)
+    {
+        candidates.clear();
+        for(int h_u=0; h_u<k; h_u++)
+        {
+            if(sigs[g_u].coversDegrees(querySigs[h_u]) && criteria.isNodeMatch(g, g_u, h, h_u))
+                candidates.push_back(h_u);
+        }
+        // Flows are the expensive part, so only count them for nodes that
+        // are still candidates
+        if(useFlows && !candidates.empty())
+            countFlows(g, g_u, delta, limits, sigs[g_u]);
+        for(int h_u : candidates)
+        {
+            if(!useFlows || sigs[g_u].coversFlows(querySigs[h_u]))
+            {
+                add(h_u, g_u);
+                _nodes[h_u].push_back(g_u);
+            }
+        }
+    }
+
+    if(!anyEmpty())
+        narrow(g, h, criteria);
+}
+
+bool NodeDomains::anyEmpty() const
+{
+    for(const vector<int> &domain : _nodes)
+    {
+        if(domain.empty())
+            return true;
+    }
+    return false;
+}
+
+bool NodeDomains::Signature::coversDegrees(const Signature &q) const
+{
+    return numIn >= q.numIn && numOut >= q.numOut &&
+        numInNeighbors >= q.numInNeighbors && numOutNeighbors >= q.numOutNeighbors &&
+        numRecipNeighbors >= q.numRecipNeighbors;
+}
+
+bool NodeDomains::Signature::coversFlows(const Signature &q) const
+{
+    for(int f=0; f<NUM_FLOW_TYPES; f++)
+    {
+        if(flows2[f] < q.flows2[f] || flows3[f] < q.flows3[f])
+            return false;
+    }
+    return true;
+}
+
+bool NodeDomains::Signature::hasFlows() const
+{
+    for(int f=0; f<NUM_FLOW_TYPES; f++)
+    {
+        if(flows2[f] > 0 || flows3[f] > 0)
+            return true;
+    }
+    return false;
+}
+
+void NodeDomains::countDegrees(const Graph &g, vector<Signature> &sigs)
+{
+    int n = g.numNodes();
+    const EdgeList &edges = g.edges();
+    sigs.assign(n, Signature());
+    // Last node each node was counted as a neighbor of
+    vector<int> outMarks(n, -1), inMarks(n, -1);
+    for(int u=0; u<n; u++)
+    {
+        const Node &node = g.nodes()[u];
+        Signature &sig = sigs[u];
+        sig.numOut = node.outEdges().size();
+        sig.numIn = node.inEdges().size();
+        for(int e : node.outEdges())
+        {
+            int w = edges.dests()[e];
+            if(outMarks[w] == u)
+                continue;
+            outMarks[w] = u;
+            sig.numOutNeighbors++;
+            if(g.hasEdge(w, u))
+                sig.numRecipNeighbors++;
+        }
+        for(int e : node.inEdges())
+        {
+            int w = edges.sources()[e];
+            if(inMarks[w] == u)
+                continue;
+            inMarks[w] = u;
+            sig.numInNeighbors++;
+        }
+    }
+}
+
+namespace
+{
+    /** Number of edges in the list (in chronological order) with times from lo to hi */
+    int countInTimeRange(const int *begin, const int *end, const time_t *times, time_t lo, time_t hi)
+    {
+        const int *first = std::lower_bound(begin, end, lo, [times](int e, time_t t) { return times[e] < t; });
+        const int *last = std::upper_bound(first, end, hi, [times](time_t t, int e) { return t < times[e]; });
+        return last - first;
+    }
+}
+
+void NodeDomains::countFlows(const Graph &g, int u, time_t delta, const Signature &limits, Signature &sig)
+{
+    const Node &node = g.nodes()[u];
+    const EdgeList &edges = g.edges();
+    const time_t *times = edges.times().data();
+    enum { IN, OUT };
+    const Column<int> *lists[2] = { &node.inEdges(), &node.outEdges() };
+    const Column<time_t> *listTimes[2] = { &node.inEdgeTimes(), &node.outEdgeTimes() };
+    const int *neighbors[2] = { edges.sources().data(), edges.dests().data() };
+
+    // Edges between u and w, in the given direction (from u's point of view)
+    auto pairEdges = [&](int w, int dir) -> EdgeRange
+    {
+        int source = (dir == IN) ? w : u;
+        int dest = (dir == IN) ? u : w;
+        return g.hasEdge(source, dest) ? g.getEdgeIndexes(source, dest) : EdgeRange();
+    };
+    auto needed = [&](int f) { return limits.flows2[f] > 0 || limits.flows3[f] > 0; };
+    // Once there are enough flows of a kind for every query node, there's no need to count the rest
+    auto enough = [&](int f) { return sig.flows2[f] >= limits.flows2[f] && sig.flows3[f] >= limits.flows3[f]; };
+
+    // Flows where the first edge comes strictly before the second, by the
+    // direction of each
+    const int SEQ_FLOWS[2][2] = { { FLOW_IN_IN, FLOW_IN_OUT }, { FLOW_OUT_IN, FLOW_OUT_OUT } };
+    for(int dir1=IN; dir1<=OUT; dir1++)
+    {
+        for(int dir2=IN; dir2<=OUT; dir2++)
+        {
+            int f = SEQ_FLOWS[dir1][dir2];
+            if(!needed(f))
+                continue;
+            const Column<int> &first = *lists[dir1];
+            const Column<int> &second = *lists[dir2];
+            for(int e2 : second)
+            {
+                if(enough(f))
+                    break;
+                time_t lo = times[e2] - delta;
+                time_t hi = times[e2] - 1;
+                long total = countInTimeRange(first.begin(), first.end(), times, lo, hi);
+                if(total == 0)
+                    continue;
+                EdgeRange same = pairEdges(neighbors[dir2][e2], dir1);
+                long two = countInTimeRange(same.begin(), same.end(), times, lo, hi);
+                sig.flows2[f] += two;
+                sig.flows3[f] += total - two;
+            }
+        }
+    }
+
+    // Flows with an edge in each direction at the same time
+    if(needed(FLOW_SYNC_IN_OUT))
+    {
+        for(int e2 : *lists[OUT])
+        {
+            if(enough(FLOW_SYNC_IN_OUT))
+                break;
+            time_t t = times[e2];
+            long total = countInTimeRange(lists[IN]->begin(), lists[IN]->end(), times, t, t);
+            if(total == 0)
+                continue;
+            EdgeRange same = pairEdges(neighbors[OUT][e2], IN);
+            long two = countInTimeRange(same.begin(), same.end(), times, t, t);
+            sig.flows2[FLOW_SYNC_IN_OUT] += two;
+            sig.flows3[FLOW_SYNC_IN_OUT] += total - two;
+        }
+    }
+
+    // Flows with both edges in the same direction at the same time (each
+    // pair is counted by its later edge)
+    const int SYNC_FLOWS[2] = { FLOW_SYNC_IN_IN, FLOW_SYNC_OUT_OUT };
+    for(int dir=IN; dir<=OUT; dir++)
+    {
+        int f = SYNC_FLOWS[dir];
+        if(!needed(f))
+            continue;
+        const Column<int> &list = *lists[dir];
+        const Column<time_t> &listTime = *listTimes[dir];
+        for(int j=0; j<(int)list.size() && !enough(f); j++)
+        {
+            int e2 = list[j];
+            time_t t = times[e2];
+            long total = j - (std::lower_bound(listTime.begin(), listTime.begin() + j, t) - listTime.begin());
+            if(total == 0)
+                continue;
+            // Edges are listed in the same order in the pair index
+            EdgeRange same = pairEdges(neighbors[dir][e2], dir);
+            const int *pos = std::lower_bound(same.begin(), same.end(), e2);
+            long two = pos - std::lower_bound(same.begin(), pos, t, [times](int e, time_t t) { return times[e] < t; });
+            sig.flows2[f] += two;
+            sig.flows3[f] += total - two;
+        }
+    }
+}
+
+NodeDomains::Signature NodeDomains::querySignature(const Graph &h, int u)
+{
+    // Edges of u (without self loops), with the direction from u's point of view
+    struct NodeEdge
+    {
+        bool out;
+        int neighbor;
+        time_t time;
+    };
+    const Node &node = h.nodes()[u];
+    const EdgeList &edges = h.edges();
+    vector<NodeEdge> nodeEdges;
+    for(int e : node.inEdges())
+    {
+        if(edges.sources()[e] != u)
+            nodeEdges.push_back(NodeEdge{false, edges.sources()[e], edges.times()[e]});
+    }
+    for(int e : node.outEdges())
+    {
+        if(edges.dests()[e] != u)
+            nodeEdges.push_back(NodeEdge{true, edges.dests()[e], edges.times()[e]});
+    }
+    std::sort(nodeEdges.begin(), nodeEdges.end(), [](const NodeEdge &a, const NodeEdge &b)
+    {
+        return std::tie(a.out, a.neighbor, a.time) < std::tie(b.out, b.neighbor, b.time);
+    });
+    nodeEdges.erase(std::unique(nodeEdges.begin(), nodeEdges.end(), [](const NodeEdge &a, const NodeEdge &b)
+    {
+        return a.out == b.out && a.neighbor == b.neighbor && a.time == b.time;
+    }), nodeEdges.end());
+
+    Signature sig;
+    vector<int> inNeighbors, outNeighbors;
+    for(const NodeEdge &edge : nodeEdges)
+    {
+        if(edge.out)
+        {
+            sig.numOut++;
+            outNeighbors.push_back(edge.neighbor);
+        }
+        else
+        {
+            sig.numIn++;
+            inNeighbors.push_back(edge.neighbor);
+        }
+    }
+    std::sort(inNeighbors.begin(), inNeighbors.end());
+    std::sort(outNeighbors.begin(), outNeighbors.end());
+    inNeighbors.erase(std::unique(inNeighbors.begin(), inNeighbors.end()), inNeighbors.end());
+    outNeighbors.erase(std::unique(outNeighbors.begin(), outNeighbors.end()), outNeighbors.end());
+    sig.numInNeighbors = inNeighbors.size();
+    sig.numOutNeighbors = outNeighbors.size();
+    for(int w : outNeighbors)
+    {
+        if(std::binary_search(inNeighbors.begin(), inNeighbors.end(), w))
+            sig.numRecipNeighbors++;
+    }
+
+    // Every pair of edges is a flow, since a match has all of its edges within delta
+    const int SEQ_FLOWS[2][2] = { { FLOW_IN_IN, FLOW_IN_OUT }, { FLOW_OUT_IN, FLOW_OUT_OUT } };
+    for(int i=0; i<(int)nodeEdges.size(); i++)
+    {
+        for(int j=i+1; j<(int)nodeEdges.size(); j++)
+        {
+            const NodeEdge *a = &nodeEdges[i];
+            const NodeEdge *b = &nodeEdges[j];
+            int f;
+            if(a->time == b->time)
+            {
+                if(a->out != b->out)
+                    f = FLOW_SYNC_IN_OUT;
+                else
+                    f = a->out ? FLOW_SYNC_OUT_OUT : FLOW_SYNC_IN_IN;
+            }
+            else
+            {
+                if(b->time < a->time)
+                    std::swap(a, b);
+                f = SEQ_FLOWS[a->out][b->out];
+            }
+            if(a->neighbor == b->neighbor)
+                sig.flows2[f]++;
+            else
+                sig.flows3[f]++;
+        }
+    }
+    return sig;
+}
+
+void NodeDomains::narrow(const Graph &g, const Graph &h, const MatchCriteria &criteria)
+{
+    const EdgeList &gEdges = g.edges();
+    const EdgeList &hEdges = h.edges();
+    int numQueryEdges = h.numEdges();
+
+    // Query edges whose ends need to be checked again
+    vector<bool> dirty(numQueryEdges, true);
+    bool anyDirty = true;
+    while(anyDirty)
+    {
+        anyDirty = false;
+        for(int h_e=0; h_e<numQueryEdges; h_e++)
+        {
+            if(!dirty[h_e])
+                continue;
+            dirty[h_e] = false;
+            int h_u = hEdges.sources()[h_e];
+            int h_v = hEdges.dests()[h_e];
+            if(h_u == h_v)
+                continue;
+
+            // Check both ends of the query edge
+            for(int end=0; end<2; end++)
+            {
+                bool out = (end == 0);
+                int h_this = out ? h_u : h_v;
+                int h_other = out ? h_v : h_u;
+                vector<int> &domain = _nodes[h_this];
+                int numKept = 0;
+                for(int g_u : domain)
+                {
+                    // Look for a matching edge to a candidate of the other end
+                    const Node &node = g.nodes()[g_u];
+                    const Column<int> &nodeEdges = out ? node.outEdges() : node.inEdges();
+                    const int *others = out ? gEdges.dests().data() : gEdges.sources().data();
+                    bool supported = false;
+                    for(int g_e : nodeEdges)
+                    {
+                        int g_other = others[g_e];
+                        if(g_other != g_u && contains(h_other, g_other) && criteria.isEdgeMatch(g, g_e, h, h_e))
+                        {
+                            supported = true;
+                            break;
+                        }
+                    }
+                    if(supported)
+                        domain[numKept++] = g_u;
+                    else
+                        remove(h_this, g_u);
+                }
+                if(numKept == (int)domain.size())
+                    continue;
+                domain.resize(numKept);
+
+                // The query edges of this node need checking again
+                for(int h_f=0; h_f<numQueryEdges; h_f++)
+                {
+                    if(hEdges.sources()[h_f] == h_this || hEdges.dests()[h_f] == h_this)
+                    {
+                        dirty[h_f] = true;
+                        anyDirty = true;
+                    }
+                }
+                if(domain.empty())
+                    return;
+            }
+        }
+    }
+}
@@ -0,0 +1,102 @@
+/*
+ * File:   NodeDomains.h
+ * Author: D3M430
+ *
+ * Created on March 26, 2021, 9:05 AM
+ */
+
+#ifndef NODEDOMAINS_H
+#define	NODEDOMAINS_H
+
+#include "Graph.h"
+#include "MatchCriteria.h"
+#include <stdint.h>
+#include <time.h>
+#include <vector>
+
+/**
+ * The nodes of G that each node of a query graph H could possibly be
+ * matched to (its domain), as a bitset per query node.  A node of G is
+ * only a candidate if it matches the node criteria, and has at least as
+ * many edges, neighbors and temporal flows (pairs of edges through the
+ * node, within delta) of each kind as the query node.  The domains are
+ * then narrowed down until every candidate has a matching edge to a
+ * candidate of each of its query node's neighbors.  Based on
+ * computeDomains and getFlowDegrees in the Java TemporalRI code.
+ */
+class NodeDomains
+{
+public:
+    /**
+     * Computes the domains of each node in h.
+     * @param g  The graph we are searching.
+     * @param h  The query graph.
+     * @param criteria  Criteria for matching nodes and edges.
+     * @param delta  The max time duration allowed between edge matches.
+     * @param ordered  True if the time order of the edges must match (so the
+     * edge counts and temporal flows can be used to filter the nodes).  If
+     * false, only the node criteria and neighbor counts are used, since
+     * several query edges can be matched to the same edge.
+     */
+    void compute(const Graph &g, const Graph &h, const MatchCriteria &criteria, time_t delta, bool ordered = true);
+    /** True if g_u is in the domain of query node h_u */
+    bool contains(int h_u, int g_u) const { return (_bits[h_u][g_u >> 6] >> (g_u & 63)) & 1; }
+    /** Nodes in the domain of query node h_u, in increasing order */
+    const std::vector<int> &nodes(int h_u) const { return _nodes[h_u]; }
+    int size(int h_u) const { return _nodes[h_u].size(); }
+    /** True if some query node has an empty domain, so there can't be any matches */
+    bool anyEmpty() const;
+
+private:
+    /** Kinds of temporal flows through a node (pairs of edges at the node) */
+    enum FlowType
+    {
+        // One edge strictly before the other, by the direction of each edge
+        FLOW_IN_IN, FLOW_IN_OUT, FLOW_OUT_IN, FLOW_OUT_OUT,
+        // Both edges at the same time
+        FLOW_SYNC_IN_IN, FLOW_SYNC_IN_OUT, FLOW_SYNC_OUT_OUT,
+        NUM_FLOW_TYPES
+    };
+
+    /** Counts a query or data node must have to match */
+    struct Signature
+    {
+        long numIn = 0, numOut = 0;
+        long numInNeighbors = 0, numOutNeighbors = 0, numRecipNeighbors = 0;
+        // Flows where both edges have the same neighbor, and where they don't
+        long flows2[NUM_FLOW_TYPES] = {}, flows3[NUM_FLOW_TYPES] = {};
+        /** True if there are at least as many edges and neighbors as in q */
+        bool coversDegrees(const Signature &q) const;
+        /** True if there are at least as many flows of each kind as in q */
+        bool coversFlows(const Signature &q) const;
+        /** True if any flows need to be counted */
+        bool hasFlows() const;
+    };
+
+    /** Counts the edges and neighbors of every node in g (including self loops, since this
+     * is only used to rule nodes out) */
+    static void countDegrees(const Graph &g, std::vector<Signature> &sigs);
+    /**
+     * Counts the flows through node u of g within delta.
+     * @param limits  Most flows of each kind any query node has.  Kinds that
+     * no query node has aren't counted, and the rest are only counted until
+     * there are that many.
+     */
+    static void countFlows(const Graph &g, int u, time_t delta, const Signature &limits, Signature &sig);
+    /** Counts the edges, neighbors and flows of node u in the query graph (without self loops).
+     * Edges with the same time and the same ends are only counted once, since the ordered
+     * search can match them to the same edge. */
+    static Signature querySignature(const Graph &h, int u);
+
+    void add(int h_u, int g_u) { _bits[h_u][g_u >> 6] |= uint64_t(1) << (g_u & 63); }
+    void remove(int h_u, int g_u) { _bits[h_u][g_u >> 6] &= ~(uint64_t(1) << (g_u & 63)); }
+    /** Removes candidates without a matching edge to a candidate of each query neighbor,
+     * until none are left to remove */
+    void narrow(const Graph &g, const Graph &h, const MatchCriteria &criteria);
+
+    std::vector<std::vector<uint64_t>> _bits;
+    std::vector<std::vector<int>> _nodes;
+};
+
+#endif	/* NODEDOMAINS_H */
+
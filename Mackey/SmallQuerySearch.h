@@ -0,0 +1,530 @@
+/*
+ * File:   SmallQuerySearch.h
+ * Author: D3M430
+ *
+ * Created on April 2, 2021, 9:30 AM
+ */
+
+#ifndef SMALLQUERYSEARCH_H
+#define	SMALLQUERYSEARCH_H
+
+#include "CandidateScan.h"
+#include "DeltaCounts.h"
+#include "EdgeMasks.h"
+#include "Graph.h"
+#include "MatchOutput.h"
+#include "NodeDomains.h"
+#include "WorkStealingPool.h"
+#include <algorithm>
+#include <type_traits>
+#include <vector>
+
+/**
+ * The time order search of GraphSearch::findOrderedSubgraphs, compiled for
+ * a query with exactly NumEdges edges, touching at most NumNodes nodes.
+ * All of the search state (the query edges, the node mappings and the
+ * matched edges) is kept in fixed-size arrays, and each level of the
+ * search is its own function, so the compiler can unroll it.  Since the
+ * query is so small, whether a node in G is already matched is found by
+ * looking through the node mappings, rather than keeping a table the size
+ * of G.  The criteria are tested with the EdgeMasks worked out for the
+ * search, so they cost a single AND.
+ *
+ * Rather than always starting with the first query edge, the search starts
+ * with the anchor: the query edge the fewest edges of G meet the criteria
+ * of.  From each match of the anchor, it matches the query edges before it
+ * going back in time (within delta of the anchor), and then the ones after
+ * it going forward (within delta of the first).  When the first query edge
+ * is common and a later one is rare, this skips all the prefixes that
+ * never reach a match of the rare one.
+ */
+template<int NumEdges, int NumNodes>
+class SmallQuerySearch
+{
+public:
+    /**
+     * Sets up the search.  The query must fit (see fits()).
+     * @param g  The directed graph to search on.
+     * @param h  The directed query graph we are trying to match.
+     * @param masks  Query edges each edge of g meets the criteria of.
+     * @param delta  The max time duration allowed between edge matches.
+     * @param domains  Nodes in g each node of h can be matched to.
+     * @param output  Where to give the matches (or null to just count them).
+     * @param deltaCounts  Where to count the matches by their time span (or null).
+     */
+    SmallQuerySearch(const Graph &g, const Graph &h, const EdgeMasks &masks, int delta,
+        const NodeDomains &domains, MatchOutput *output, DeltaCounts *deltaCounts);
+    /** True if h has NumEdges edges, touching at most NumNodes nodes */
+    static bool fits(const Graph &h);
+    /**
+     * Performs the search.  With more than one thread, the graphs must be frozen.
+     * @return  The number of matching subgraphs found.
+     */
+    long run(int numThreads);
+    /** Edges of G matches can start the search with (matches of the anchor) */
+    EdgeRange roots() const { return _masks->edges(_anchor); }
+    /** Counts the matches the search finds from one of the roots, on this thread */
+    long searchRoot(int g_e);
+
+private:
+    template<int Depth> using Level = std::integral_constant<int, Depth>;
+
+    /** Part of the search: every match with the prefix edges at the first
+     * levels, that matches the next level's edge to an edge in G from begin up to end */
+    struct Task
+    {
+        int prefix[NumEdges];
+        int depth, begin, end;
+    };
+
+    /** Searches on multiple threads, giving work to threads that run out */
+    long runParallel(int numThreads);
+    /** Performs the search for a task (the prefix is mapped, and unmapped after) */
+    long searchTask(const Task &task);
+    /** Searches from the given depth (known at run time), from edge begin */
+    template<int Depth>
+    long searchFrom(Level<Depth>, int depth, int begin);
+    long searchFrom(Level<NumEdges>, int depth, int begin) { return 0; }
+    /** Matches the query edge at level Depth to edges of G from begin up to the end of
+     * its level's range, and searches the levels after it */
+    template<int Depth>
+    long searchLevel(Level<Depth>, int begin);
+    long searchLevel(Level<NumEdges>, int begin) { return 0; }
+    /** Matches the query edge at level Depth to edge g_e of G (if it can be, and it
+     * passed the CandidateScan) and searches the levels after it */
+    template<int Depth>
+    long tryEdge(Level<Depth>, int g_e);
+    /** Counts the delta and reports the match, once every query edge is matched */
+    void finishMatch();
+    /** Picks the query edge the fewest edges of G meet the criteria of (or the
+     * first, unless that one is much rarer) */
+    static int pickAnchor(const EdgeMasks &masks);
+    /** True if the node in G is matched to one of the query nodes */
+    bool matched(int g_u) const;
+    /** Gives part of the remaining search (from our task's level up to depth) to a hungry thread */
+    void donateWork(int depth);
+
+    const Graph *_g, *_h;
+    const EdgeMasks *_masks;
+    time_t _delta;
+    const NodeDomains *_domains;
+    MatchOutput *_output;
+    DeltaCounts *_deltaCounts;
+    // Query edge matched at each level: the anchor, then the ones before it
+    // (last to first), then the ones after it
+    int _anchor;
+    int _levelEdges[NumEdges];
+    // Query edge next to each level's edge in time, which is matched at an
+    // earlier level (or -1 for the anchor), and whether it's the one after it
+    int _prevEdges[NumEdges];
+    bool _backward[NumEdges];
+    // True if each level's edge happens at the same time as its neighbor
+    // (otherwise it's before or after it)
+    bool _sameTimes[NumEdges];
+    // Ends of each level's edge (numbered by first appearance), and whether
+    // each is first matched at that level
+    int _sources[NumEdges], _dests[NumEdges];
+    bool _newSources[NumEdges], _newDests[NumEdges];
+    // Original index of each query node
+    int _queryNodes[NumNodes];
+    // Node in G each query node is matched to (or -1)
+    int _h2gNodes[NumNodes];
+    // Edge in G matched to each query edge (in query order), and where each
+    // level's range of edges ends
+    int _matchEdges[NumEdges];
+    int _levelEnds[NumEdges];
+    // Pool the search is running on, our worker in it, and the depth of our current task
+    WorkStealingPool<Task> *_pool = nullptr;
+    int _worker = 0;
+    int _taskDepth = 0;
+};
+
+template<int NumEdges, int NumNodes>
+SmallQuerySearch<NumEdges, NumNodes>::SmallQuerySearch(const Graph &g, const Graph &h, const EdgeMasks &masks, int delta,
+    const NodeDomains &domains, MatchOutput *output, DeltaCounts *deltaCounts) :
+    _g(&g), _h(&h), _masks(&masks), _delta(delta), _domains(&domains), _output(output), _deltaCounts(deltaCounts)
+{
+    const EdgeList &edges = h.edges();
+    _anchor = pickAnchor(masks);
+    for(int level=0; level<NumEdges; level++)
+    {
+        int h_i = level <= _anchor ? _anchor - level : level;
+        _levelEdges[level] = h_i;
+        _backward[level] = h_i < _anchor;
+        _prevEdges[level] = level == 0 ? -1 : _backward[level] ? h_i+1 : h_i-1;
+        _sameTimes[level] = level > 0 && edges.times()[h_i] == edges.times()[_prevEdges[level]];
+    }
+
+    std::vector<int> nodeIds(h.numNodes(), -1);
+    int numNodes = 0;
+    for(int level=0; level<NumEdges; level++)
+    {
+        int h_i = _levelEdges[level];
+        int h_u = edges.sources()[h_i];
+        int h_v = edges.dests()[h_i];
+        _newSources[level] = nodeIds[h_u] < 0;
+        if(nodeIds[h_u] < 0)
+        {
+            _queryNodes[numNodes] = h_u;
+            nodeIds[h_u] = numNodes++;
+        }
+        _newDests[level] = nodeIds[h_v] < 0;
+        if(nodeIds[h_v] < 0)
+        {
+            _queryNodes[numNodes] = h_v;
+            nodeIds[h_v] = numNodes++;
+        }
+        _sources[level] = nodeIds[h_u];
+        _dests[level] = nodeIds[h_v];
+    }
+    // Unused nodes are never matched
+    for(int i=numNodes; i<NumNodes; i++)
+        _queryNodes[i] = -1;
+    std::fill(_h2gNodes, _h2gNodes + NumNodes, -1);
+    std::fill(_matchEdges, _matchEdges + NumEdges, -1);
+    std::fill(_levelEnds, _levelEnds + NumEdges, g.numEdges());
+}
+
+template<int NumEdges, int NumNodes>
+bool SmallQuerySearch<NumEdges, NumNodes>::fits(const Graph &h)
+{
+    if(h.numEdges() != NumEdges)
+        return false;
+    const EdgeList &edges = h.edges();
+    std::vector<bool> used(h.numNodes(), false);
+    int numNodes = 0;
+    for(int h_i=0; h_i<NumEdges; h_i++)
+    {
+        for(int h_u : { edges.sources()[h_i], edges.dests()[h_i] })
+        {
+            if(!used[h_u])
+            {
+                used[h_u] = true;
+                numNodes++;
+            }
+        }
+    }
+    return numNodes <= NumNodes;
+}
+
+template<int NumEdges, int NumNodes>
+int SmallQuerySearch<NumEdges, NumNodes>::pickAnchor(const EdgeMasks &masks)
+{
+    int anchor = 0;
+    for(int h_i=1; h_i<NumEdges; h_i++)
+    {
+        if(masks.edges(h_i).size() < masks.edges(anchor).size())
+            anchor = h_i;
+    }
+    // Going forward from the first edge is as good when the anchor isn't much rarer
+    const int MIN_GAIN = 2;
+    if(MIN_GAIN * masks.edges(anchor).size() >= masks.edges(0).size())
+        return 0;
+    return anchor;
+}
+
+template<int NumEdges, int NumNodes>
+long SmallQuerySearch<NumEdges, NumNodes>::run(int numThreads)
+{
+    if(numThreads > 1)
+        return runParallel(numThreads);
+    Task task;
+    task.depth = 0;
+    task.begin = 0;
+    task.end = _g->numEdges();
+    return searchTask(task);
+}
+
+template<int NumEdges, int NumNodes>
+long SmallQuerySearch<NumEdges, NumNodes>::searchRoot(int g_e)
+{
+    Task task;
+    task.depth = 0;
+    task.begin = g_e;
+    task.end = g_e + 1;
+    return searchTask(task);
+}
+
+template<int NumEdges, int NumNodes>
+long SmallQuerySearch<NumEdges, NumNodes>::runParallel(int numThreads)
+{
+    // Nothing can be built on demand while the threads are searching
+    if(!_g->frozen() || !_h->frozen())
+        throw "The graphs must be frozen to search them from multiple threads.";
+
+    // Split the first edges into many more chunks than threads (as
+    // GraphSearch does), and split up busy subtrees as threads run out
+    const int CHUNKS_PER_THREAD = 64;
+    int m = _g->numEdges();
+    int chunkSize = std::max(1, m / (numThreads * CHUNKS_PER_THREAD));
+    WorkStealingPool<Task> pool(numThreads);
+    int chunk = 0;
+    for(int begin=0; begin<m; begin+=chunkSize, chunk++)
+    {
+        Task task;
+        task.depth = 0;
+        task.begin = begin;
+        task.end = std::min(m, begin+chunkSize);
+        pool.push(chunk % numThreads, task);
+    }
+
+    std::vector<long> threadOccs(numThreads, 0);
+    std::vector<DeltaCounts> threadDeltaCounts;
+    if(_deltaCounts != nullptr)
+        threadDeltaCounts.assign(numThreads, _deltaCounts->empty());
+    pool.run([&](int worker)
+    {
+        // Each thread gets its own search state
+        SmallQuerySearch search = *this;
+        search._pool = &pool;
+        search._worker = worker;
+        if(_deltaCounts != nullptr)
+            search._deltaCounts = &threadDeltaCounts[worker];
+
+        long numOccs = 0;
+        Task task;
+        while(pool.pop(worker, task))
+        {
+            numOccs += search.searchTask(task);
+            pool.finish();
+            // Stop everyone once no more matches are wanted
+            if(_output != nullptr && _output->stopped())
+                pool.abort();
+        }
+        threadOccs[worker] = numOccs;
+    });
+
+    long numOccs = 0;
+    for(long occs : threadOccs)
+        numOccs += occs;
+    for(const DeltaCounts &counts : threadDeltaCounts)
+        _deltaCounts->merge(counts);
+    return numOccs;
+}
+
+template<int NumEdges, int NumNodes>
+long SmallQuerySearch<NumEdges, NumNodes>::searchTask(const Task &task)
+{
+    if(task.begin >= std::min(task.end, _g->numEdges()))
+        return 0;
+
+    // Put the search state back the way it was when the task was split off
+    const EdgeList &edges = _g->edges();
+    for(int level=0; level<task.depth; level++)
+    {
+        _matchEdges[_levelEdges[level]] = task.prefix[level];
+        _h2gNodes[_sources[level]] = edges.sources()[task.prefix[level]];
+        _h2gNodes[_dests[level]] = edges.dests()[task.prefix[level]];
+    }
+    _taskDepth = task.depth;
+    _levelEnds[task.depth] = task.end;
+
+    long numOccs = searchFrom(Level<0>(), task.depth, task.begin);
+
+    // Leave the search state clear for the next task
+    std::fill(_h2gNodes, _h2gNodes + NumNodes, -1);
+    std::fill(_matchEdges, _matchEdges + NumEdges, -1);
+    return numOccs;
+}
+
+template<int NumEdges, int NumNodes>
+template<int Depth>
+long SmallQuerySearch<NumEdges, NumNodes>::searchFrom(Level<Depth>, int depth, int begin)
+{
+    if(depth == Depth)
+        return searchLevel(Level<Depth>(), begin);
+    return searchFrom(Level<Depth+1>(), depth, begin);
+}
+
+template<int NumEdges, int NumNodes>
+bool SmallQuerySearch<NumEdges, NumNodes>::matched(int g_u) const
+{
+    for(int i=0; i<NumNodes; i++)
+    {
+        if(_h2gNodes[i] == g_u)
+            return true;
+    }
+    return false;
+}
+
+template<int NumEdges, int NumNodes>
+template<int Depth>
+long SmallQuerySearch<NumEdges, NumNodes>::searchLevel(Level<Depth>, int begin)
+{
+    const time_t *times = _g->edges().times().data();
+    const int h_i = _levelEdges[Depth];
+    const int g_u = _h2gNodes[_sources[Depth]];
+    const int g_v = _h2gNodes[_dests[Depth]];
+
+    // The edge happens at the same time as its neighbor, or before it (but
+    // within delta of the anchor) if it comes before the anchor, or after it
+    // (but within delta of the first) if it comes after
+    time_t minTime = 0, maxTime = 0;
+    if(Depth > 0)
+    {
+        time_t prevTime = times[_matchEdges[_prevEdges[Depth]]];
+        if(_sameTimes[Depth])
+            minTime = maxTime = prevTime;
+        else if(_backward[Depth])
+        {
+            minTime = times[_matchEdges[_anchor]] - _delta;
+            maxTime = prevTime - 1;
+        }
+        else
+        {
+            minTime = prevTime + 1;
+            maxTime = times[_matchEdges[0]] + _delta;
+        }
+    }
+
+    // Search the edges of the ends that are already matched, or the edges
+    // that meet the criteria if neither is.  The lists are in edge order
+    // (and so in time order), so the edges in the time range (and from
+    // begin on) are all together.
+    const int *first, *last;
+    CandidateScan::ListType list;
+    if(g_u < 0 && g_v < 0)
+    {
+        list = CandidateScan::MATCHING_EDGES;
+        EdgeRange candidates = _masks->edges(h_i);
+        const std::vector<time_t> &candidateTimes = _masks->times(h_i);
+        first = candidates.begin();
+        last = candidates.end();
+        if(Depth > 0)
+        {
+            first += std::lower_bound(candidateTimes.begin(), candidateTimes.end(), minTime) - candidateTimes.begin();
+            last = candidates.begin() + (std::upper_bound(candidateTimes.begin(), candidateTimes.end(), maxTime) - candidateTimes.begin());
+        }
+    }
+    else if(g_u >= 0 && g_v >= 0)
+    {
+        if(!_g->hasEdge(g_u, g_v))
+            return 0;
+        list = CandidateScan::PAIR_EDGES;
+        EdgeRange candidates = _g->getEdgeIndexes(g_u, g_v);
+        first = std::lower_bound(candidates.begin(), candidates.end(), minTime,
+            [times](int g_e, time_t t) { return times[g_e] < t; });
+        last = std::upper_bound(first, candidates.end(), maxTime,
+            [times](time_t t, int g_e) { return t < times[g_e]; });
+    }
+    else
+    {
+        list = (g_u >= 0) ? CandidateScan::SOURCE_EDGES : CandidateScan::DEST_EDGES;
+        const Node &node = _g->nodes()[g_u >= 0 ? g_u : g_v];
+        const Column<int> &nodeEdges = (g_u >= 0) ? node.outEdges() : node.inEdges();
+        const Column<time_t> &nodeTimes = (g_u >= 0) ? node.outEdgeTimes() : node.inEdgeTimes();
+        first = nodeEdges.data() + (std::lower_bound(nodeTimes.begin(), nodeTimes.end(), minTime) - nodeTimes.begin());
+        last = nodeEdges.data() + (std::upper_bound(nodeTimes.begin(), nodeTimes.end(), maxTime) - nodeTimes.begin());
+    }
+    if(begin > 0)
+        first = std::lower_bound(first, last, begin);
+    // Filter the candidates a block at a time on the simple checks, and
+    // only try the ones that pass
+    CandidateScan scan(*_g, *_masks, h_i, _sources[Depth] == _dests[Depth], g_u, g_v, list);
+    int passed[CandidateScan::BLOCK_SIZE];
+    long numOccs = 0;
+    while(first != last && *first < _levelEnds[Depth])
+    {
+        const int *blockEnd = first + std::min<long>(last - first, CandidateScan::BLOCK_SIZE);
+        int numPassed = scan.filter(first, blockEnd, passed);
+        first = blockEnd;
+        for(int i=0; i<numPassed; i++)
+        {
+            // Another thread may have taken the rest of the level
+            if(passed[i] >= _levelEnds[Depth])
+                return numOccs;
+            if(_pool != nullptr && _pool->hungry())
+                donateWork(Depth);
+            numOccs += tryEdge(Level<Depth>(), passed[i]);
+            if(_output != nullptr && _output->stopped())
+                return numOccs;
+        }
+    }
+    return numOccs;
+}
+
+template<int NumEdges, int NumNodes>
+template<int Depth>
+long SmallQuerySearch<NumEdges, NumNodes>::tryEdge(Level<Depth>, int g_e)
+{
+    const EdgeList &edges = _g->edges();
+    const int h_u = _sources[Depth], h_v = _dests[Depth];
+    int g_u = edges.sources()[g_e];
+    int g_v = edges.dests()[g_e];
+
+    // The CandidateScan has checked the criteria, the self loops, and the
+    // ends already matched.  New ends must be unmatched, and in their domains.
+    if(_newSources[Depth] && (matched(g_u) || !_domains->contains(_queryNodes[h_u], g_u)))
+        return 0;
+    if(_newDests[Depth] && h_v != h_u && (matched(g_v) || !_domains->contains(_queryNodes[h_v], g_v)))
+        return 0;
+
+    _matchEdges[_levelEdges[Depth]] = g_e;
+    _h2gNodes[h_u] = g_u;
+    _h2gNodes[h_v] = g_v;
+    long numOccs = 1;
+    if(Depth+1 == NumEdges)
+        finishMatch();
+    else
+    {
+        _levelEnds[Depth+1] = _g->numEdges();
+        numOccs = searchLevel(Level<Depth+1>(), 0);
+    }
+    if(_newSources[Depth])
+        _h2gNodes[h_u] = -1;
+    if(_newDests[Depth])
+        _h2gNodes[h_v] = -1;
+    return numOccs;
+}
+
+template<int NumEdges, int NumNodes>
+void SmallQuerySearch<NumEdges, NumNodes>::finishMatch()
+{
+    if(_deltaCounts != nullptr)
+    {
+        const time_t *times = _g->edges().times().data();
+        _deltaCounts->add(times[_matchEdges[NumEdges-1]] - times[_matchEdges[0]]);
+    }
+    if(_output != nullptr)
+        _output->report(EdgeRange(_matchEdges, _matchEdges + NumEdges));
+}
+
+template<int NumEdges, int NumNodes>
+void SmallQuerySearch<NumEdges, NumNodes>::donateWork(int depth)
+{
+    // Wait until our last donation has been taken
+    if(_pool->size(_worker) > 0)
+        return;
+
+    // Edges past delta from the anchor can't be matched by anything after it
+    const time_t *times = _g->edges().times().data();
+    int m = _g->numEdges();
+    int deltaEnd = m;
+    if(depth > 0)
+        deltaEnd = std::upper_bound(times, times + m, times[_matchEdges[_anchor]] + _delta) - times;
+
+    // Give away the second half of the untried edges at the shallowest level
+    // we can, since it's likely to have the biggest subtrees left
+    const int MIN_DONATION = 2;
+    for(int level=_taskDepth; level<depth; level++)
+    {
+        int begin = _matchEdges[_levelEdges[level]] + 1;
+        int end = _levelEnds[level];
+        int usefulEnd = level == 0 ? end : std::min(end, deltaEnd);
+        if(usefulEnd - begin < MIN_DONATION)
+            continue;
+        int split = begin + (usefulEnd - begin)/2;
+
+        Task task;
+        for(int i=0; i<level; i++)
+            task.prefix[i] = _matchEdges[_levelEdges[i]];
+        task.depth = level;
+        task.begin = split;
+        task.end = end;
+        _levelEnds[level] = split;
+        _pool->push(_worker, task);
+        return;
+    }
+}
+
+#endif	/* SMALLQUERYSEARCH_H */
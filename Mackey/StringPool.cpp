@@ -0,0 +1,94 @@
+#include "StringPool.h"
+
+using namespace std;
+
+StringPool::StringPool()
+{
+    clear();
+}
+
+int StringPool::intern(StringView str)
+{
+    uint64_t h = hash(str);
+    size_t slot = findSlot(str, h);
+    if(_table[slot] >= 0)
+        return _table[slot];
+
+    // Keep the table at most half full
+    int id = size();
+    if(2*(size_t)(id+1) > _table.size())
+    {
+        rehash(id+1);
+        slot = findSlot(str, h);
+    }
+    // The characters could be in our own array, which may move when it grows
+    if(str.data() >= _chars.data() && str.data() < _chars.data() + _chars.size())
+    {
+        string copy = str.str();
+        _chars.insert(_chars.end(), copy.begin(), copy.end());
+    }
+    else
+        _chars.insert(_chars.end(), str.begin(), str.end());
+    _offsets.push_back(_chars.size());
+    _table[slot] = id;
+    return id;
+}
+
+int StringPool::find(StringView str) const
+{
+    return _table[findSlot(str, hash(str))];
+}
+
+void StringPool::reserve(int numStrings, size_t numChars)
+{
+    _chars.reserve(numChars);
+    _offsets.reserve(numStrings+1);
+    if(2*(size_t)numStrings > _table.size())
+        rehash(numStrings);
+}
+
+void StringPool::clear()
+{
+    _chars.clear();
+    _offsets.assign(1, 0);
+    _table.assign(16, -1);
+}
+
+uint64_t StringPool::hash(StringView str)
+{
+    // FNV-1a
+    uint64_t h = 14695981039346656037ULL;
+    for(char c : str)
+    {
+        h ^= (unsigned char)c;
+        h *= 1099511628211ULL;
+    }
+    return h;
+}
+
+size_t StringPool::findSlot(StringView str, uint64_t h) const
+{
+    // Linear probing
+    size_t mask = _table.size() - 1;
+    size_t slot = h & mask;
+    while(_table[slot] >= 0 && get(_table[slot]) != str)
+        slot = (slot + 1) & mask;
+    return slot;
+}
+
+void StringPool::rehash(int numStrings)
+{
+    size_t tableSize = 16;
+    while(tableSize < 2*(size_t)numStrings)
+        tableSize *= 2;
+    _table.assign(tableSize, -1);
+    size_t mask = tableSize - 1;
+    for(int id=0; id<size(); id++)
+    {
+        size_t slot = hash(get(id)) & mask;
+        while(_table[slot] >= 0)
+            slot = (slot + 1) & mask;
+        _table[slot] = id;
+    }
+}
+
@@ -0,0 +1,87 @@
+/*
+ * File:   StringPool.h
+ * Author: D3M430
+ *
+ * Created on March 15, 2021, 10:20 AM
+ */
+
+#ifndef STRINGPOOL_H
+#define	STRINGPOOL_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * Read-only view of characters stored somewhere else (like a std::string
+ * or a StringPool).  Only valid for as long as those characters are.
+ */
+class StringView
+{
+public:
+    StringView() : _data(""), _size(0) {}
+    StringView(const char *data, size_t size) : _data(data), _size(size) {}
+    StringView(const char *str) : _data(str), _size(strlen(str)) {}
+    StringView(const std::string &str) : _data(str.data()), _size(str.size()) {}
+    const char *data() const { return _data; }
+    size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+    const char *begin() const { return _data; }
+    const char *end() const { return _data + _size; }
+    char operator[](size_t i) const { return _data[i]; }
+    std::string str() const { return std::string(_data, _size); }
+    operator std::string() const { return str(); }
+    bool operator==(const StringView &rhs) const { return _size == rhs._size && memcmp(_data, rhs._data, _size) == 0; }
+    bool operator!=(const StringView &rhs) const { return !(*this == rhs); }
+private:
+    const char *_data;
+    size_t _size;
+};
+
+inline std::ostream &operator<<(std::ostream &os, const StringView &s)
+{
+    return os.write(s.data(), s.size());
+}
+
+/**
+ * Interns strings, so each distinct string is only stored once.  The
+ * characters of every string are kept back to back in one array, and an
+ * open addressing hash table maps each string to its ID.  IDs start at 0,
+ * in the order the strings were first added.
+ */
+class StringPool
+{
+public:
+    StringPool();
+    /** Adds the string if it's new.  Returns the ID of the string. */
+    int intern(StringView str);
+    /** ID of the string, or -1 if it hasn't been added */
+    int find(StringView str) const;
+    /** The string with the given ID.  It stays valid until the next string is added. */
+    StringView get(int id) const { return StringView(_chars.data() + _offsets[id], _offsets[id+1] - _offsets[id]); }
+    /** Number of distinct strings */
+    int size() const { return _offsets.size() - 1; }
+    /** Makes room for the given number of strings and characters */
+    void reserve(int numStrings, size_t numChars);
+    /** Removes all strings */
+    void clear();
+private:
+    static uint64_t hash(StringView str);
+    /** Slot in the hash table holding the string, or the empty slot where it belongs */
+    size_t findSlot(StringView str, uint64_t h) const;
+    /** Resizes the hash table so it holds at least the given number of strings */
+    void rehash(int numStrings);
+
+    // Characters of all the strings
+    std::vector<char> _chars;
+    // Where each string starts in _chars (plus the end of the last one)
+    std::vector<uint64_t> _offsets;
+    // Hash table of string IDs (-1 for empty slots).  Size is a power of 2.
+    std::vector<int> _table;
+};
+
+#endif	/* STRINGPOOL_H */
+
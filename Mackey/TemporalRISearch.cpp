@@ -0,0 +1,286 @@
+#include "TemporalRISearch.h"
+#include "WorkStealingPool.h"
+#include <algorithm>
+#include <limits>
+
+using namespace std;
+
+long TemporalRISearch::findOrderedSubgraphs(const Graph &g, const Graph &h, const MatchCriteria &criteria, int limit, int delta)
+{
+    // Only go through a sink if there's a limit to stop at
+    if(limit < INT_MAX)
+        return findOrderedSubgraphs(g, h, criteria, [](EdgeRange) { return true; }, limit, delta);
+    return search(g, h, criteria, delta, nullptr, nullptr);
+}
+
+long TemporalRISearch::findOrderedSubgraphs(const Graph &g, const Graph &h, const MatchCriteria &criteria, const MatchSink &sink, int limit, int delta)
+{
+    MatchOutput output(sink, limit);
+    if(!output.stopped())
+        search(g, h, criteria, delta, &output, nullptr);
+    return output.numMatches();
+}
+
+vector<long> TemporalRISearch::countOrderedSubgraphs(const Graph &g, const Graph &h, const MatchCriteria &criteria, const vector<time_t> &deltas)
+{
+    DeltaCounts counts(deltas);
+    if(!deltas.empty())
+        search(g, h, criteria, counts.maxDelta(), nullptr, &counts);
+    return counts.counts();
+}
+
+long TemporalRISearch::search(const Graph &g, const Graph &h, const MatchCriteria &criteria, time_t delta, MatchOutput *output, DeltaCounts *deltaCounts)
+{
+    _output = output;
+    _deltaCounts = deltaCounts;
+    _g = &g;
+    _h = &h;
+    _criteria = &criteria;
+    _delta = delta;
+    if(h.numEdges() == 0)
+        return 0;
+
+    // Make sure the edges (and the node edge lists) are in chronological order
+    g.edges();
+    h.edges();
+
+    // Find the nodes of G each query node could be matched to
+    _domains.compute(g, h, criteria, delta);
+    if(_domains.anyEmpty())
+        return 0;
+    vector<int> domainSizes;
+    for(int h_u=0; h_u<h.numNodes(); h_u++)
+        domainSizes.push_back(_domains.size(h_u));
+    MatchingMachine mama(h, domainSizes);
+    _mama = &mama;
+    resetSearchState();
+
+    long numOccs = 0;
+    if(_numThreads > 1)
+        numOccs = findOrderedSubgraphsParallel();
+    else
+    {
+        for(int g_u : _domains.nodes(mama.stateNode(0)))
+        {
+            numOccs += searchFrom(g_u);
+            if(_output != nullptr && _output->stopped())
+                break;
+        }
+    }
+    _mama = nullptr;
+    return numOccs;
+}
+
+void TemporalRISearch::setNumThreads(int numThreads)
+{
+    if(numThreads < 1)
+        throw "The number of threads to search with must be at least 1.";
+    _numThreads = numThreads;
+}
+
+void TemporalRISearch::resetSearchState()
+{
+    _solutionNodes.assign(_mama->numNodeStates(), -1);
+    _solutionEdges.assign(_mama->numEdgeStates(), -1);
+    _minTimes.assign(_mama->numEdgeStates(), 0);
+    _maxTimes.assign(_mama->numEdgeStates(), 0);
+    _matched.assign(_g->numNodes(), false);
+    _matchEdges.assign(_h->numEdges(), -1);
+}
+
+long TemporalRISearch::findOrderedSubgraphsParallel()
+{
+    // Nothing can be built on demand while the threads are searching
+    if(!_g->frozen() || !_h->frozen())
+        throw "The graphs must be frozen to search them from multiple threads.";
+
+    // Split the first node's candidates into many more chunks than threads,
+    // since some will have far more matches than others
+    struct StartRange
+    {
+        int begin, end;
+    };
+    const int CHUNKS_PER_THREAD = 64;
+    const vector<int> &starts = _domains.nodes(_mama->stateNode(0));
+    int numStarts = starts.size();
+    int chunkSize = std::max(1, numStarts / (_numThreads * CHUNKS_PER_THREAD));
+    WorkStealingPool<StartRange> pool(_numThreads);
+    int chunk = 0;
+    for(int begin=0; begin<numStarts; begin+=chunkSize, chunk++)
+        pool.push(chunk % _numThreads, StartRange{begin, std::min(numStarts, begin+chunkSize)});
+
+    vector<long> threadOccs(_numThreads, 0);
+    vector<DeltaCounts> threadDeltaCounts;
+    if(_deltaCounts != nullptr)
+        threadDeltaCounts.assign(_numThreads, _deltaCounts->empty());
+    pool.run([&](int worker)
+    {
+        // Each thread gets its own search state
+        TemporalRISearch search = *this;
+        if(_deltaCounts != nullptr)
+            search._deltaCounts = &threadDeltaCounts[worker];
+        long numOccs = 0;
+        StartRange range;
+        while(pool.pop(worker, range))
+        {
+            for(int i=range.begin; i<range.end; i++)
+                numOccs += search.searchFrom(starts[i]);
+            pool.finish();
+            // Stop everyone once no more matches are wanted
+            if(_output != nullptr && _output->stopped())
+                pool.abort();
+        }
+        threadOccs[worker] = numOccs;
+    });
+
+    long numOccs = 0;
+    for(long occs : threadOccs)
+        numOccs += occs;
+    for(const DeltaCounts &counts : threadDeltaCounts)
+        _deltaCounts->merge(counts);
+    return numOccs;
+}
+
+long TemporalRISearch::searchFrom(int g_u)
+{
+    _solutionNodes[0] = g_u;
+    _matched[g_u] = true;
+    long numOccs = search(0);
+    _matched[g_u] = false;
+    _solutionNodes[0] = -1;
+    return numOccs;
+}
+
+long TemporalRISearch::search(int si)
+{
+    const MatchingMachine::EdgeState &state = _mama->edgeState(si);
+    const EdgeList &edges = _g->edges();
+    const time_t *times = edges.times().data();
+
+    // Range of times the edge can have, so the edges stay in the same order
+    // as in the query, and within delta of each other
+    time_t minTime = numeric_limits<time_t>::min();
+    time_t maxTime = numeric_limits<time_t>::max();
+    if(si > 0)
+    {
+        minTime = _maxTimes[si-1] - _delta;
+        maxTime = _minTimes[si-1] + _delta;
+        if(state.lowerState >= 0 && state.lowerState == state.upperState)
+        {
+            minTime = std::max(minTime, times[_solutionEdges[state.lowerState]]);
+            maxTime = std::min(maxTime, times[_solutionEdges[state.upperState]]);
+        }
+        else
+        {
+            if(state.lowerState >= 0)
+                minTime = std::max(minTime, times[_solutionEdges[state.lowerState]] + 1);
+            if(state.upperState >= 0)
+                maxTime = std::min(maxTime, times[_solutionEdges[state.upperState]] - 1);
+        }
+        if(minTime > maxTime)
+            return 0;
+    }
+
+    long numOccs = 0;
+    int g_source = _solutionNodes[state.sourceState];
+    int g_dest = _solutionNodes[state.destState];
+    if(g_source >= 0)
+    {
+        // Both ends are matched, so the candidates are the edges between them
+        int u = (state.type == MatchingMachine::OUT) ? g_source : g_dest;
+        int v = (state.type == MatchingMachine::OUT) ? g_dest : g_source;
+        if(!_g->hasEdge(u, v))
+            return 0;
+        EdgeRange candidates = _g->getEdgeIndexes(u, v);
+        const int *it = std::lower_bound(candidates.begin(), candidates.end(), minTime,
+            [times](int g_e, time_t t) { return times[g_e] < t; });
+        for(; it != candidates.end() && times[*it] <= maxTime; ++it)
+        {
+            numOccs += tryCandidate(si, *it, -1);
+            if(_output != nullptr && _output->stopped())
+                break;
+        }
+    }
+    else
+    {
+        // The edge adds a new node, so the candidates are the edges of the
+        // matched end that lead to an unmatched node in the new node's domain
+        const Node &node = _g->nodes()[g_dest];
+        bool out = (state.type == MatchingMachine::OUT);
+        const Column<int> &nodeEdges = out ? node.inEdges() : node.outEdges();
+        const Column<time_t> &nodeTimes = out ? node.inEdgeTimes() : node.outEdgeTimes();
+        const int *ends = out ? edges.sources().data() : edges.dests().data();
+        int h_new = _mama->stateNode(state.sourceState);
+        int numNodeEdges = nodeEdges.size();
+        int k = std::lower_bound(nodeTimes.begin(), nodeTimes.end(), minTime) - nodeTimes.begin();
+        for(; k<numNodeEdges && nodeTimes[k] <= maxTime; k++)
+        {
+            int g_e = nodeEdges[k];
+            int g_new = ends[g_e];
+            if(_matched[g_new] || !_domains.contains(h_new, g_new))
+                continue;
+            numOccs += tryCandidate(si, g_e, g_new);
+            if(_output != nullptr && _output->stopped())
+                break;
+        }
+    }
+    return numOccs;
+}
+
+long TemporalRISearch::tryCandidate(int si, int g_e, int g_new)
+{
+    const MatchingMachine::EdgeState &state = _mama->edgeState(si);
+
+    // Each query edge needs a different edge in G
+    for(int sj=0; sj<si; sj++)
+    {
+        if(_solutionEdges[sj] == g_e)
+            return 0;
+    }
+    if(!_criteria->isEdgeMatch(*_g, g_e, *_h, state.edge))
+        return 0;
+    if(si+1 == _mama->numEdgeStates())
+    {
+        if(_deltaCounts != nullptr)
+        {
+            time_t t = _g->edges().times()[g_e];
+            time_t span = (si == 0) ? 0 : std::max(_maxTimes[si-1], t) - std::min(_minTimes[si-1], t);
+            _deltaCounts->add(span);
+        }
+        if(_output != nullptr)
+        {
+            _solutionEdges[si] = g_e;
+            reportMatch();
+            _solutionEdges[si] = -1;
+        }
+        return 1;
+    }
+
+    time_t t = _g->edges().times()[g_e];
+    _solutionEdges[si] = g_e;
+    _minTimes[si] = (si == 0) ? t : std::min(_minTimes[si-1], t);
+    _maxTimes[si] = (si == 0) ? t : std::max(_maxTimes[si-1], t);
+    if(g_new >= 0)
+    {
+        _solutionNodes[state.sourceState] = g_new;
+        _matched[g_new] = true;
+    }
+
+    long numOccs = search(si+1);
+
+    if(g_new >= 0)
+    {
+        _matched[g_new] = false;
+        _solutionNodes[state.sourceState] = -1;
+    }
+    _solutionEdges[si] = -1;
+    return numOccs;
+}
+
+bool TemporalRISearch::reportMatch()
+{
+    // Put the edges back in query edge order
+    for(int si=0; si<_mama->numEdgeStates(); si++)
+        _matchEdges[_mama->edgeState(si).edge] = _solutionEdges[si];
+    return _output->report(_matchEdges);
+}
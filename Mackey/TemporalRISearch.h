@@ -0,0 +1,107 @@
+/*
+ * File:   TemporalRISearch.h
+ * Author: D3M430
+ *
+ * Created on March 24, 2021, 1:30 PM
+ */
+
+#ifndef TEMPORALRISEARCH_H
+#define	TEMPORALRISEARCH_H
+
+#include "DeltaCounts.h"
+#include "Graph.h"
+#include "MatchCriteria.h"
+#include "MatchingMachine.h"
+#include "MatchOutput.h"
+#include "NodeDomains.h"
+#include <limits.h>
+#include <vector>
+
+/**
+ * Ordered subgraph search using the TemporalRI algorithm (ported from
+ * src/matching/RISolver.java).  Instead of matching the query edges in
+ * time order, it matches them in the order of a MatchingMachine, so each
+ * query edge after the first is matched among the edges of a node that's
+ * already matched, within the time bounds set by the edges matched so far.
+ * Finds the same subgraphs as GraphSearch::findOrderedSubgraphs.
+ */
+class TemporalRISearch
+{
+public:
+    /**
+     * Counts the subgraphs of g that match h, with the edges in the same
+     * time order, all within delta of each other.
+     * @param g  The directed graph to search on.
+     * @param h  The directed query graph we are trying to match.  Must be
+     * connected, and have no self loops.
+     * @param criteria  Polymorphic class specifies whether or not two given edges match the query criteria.
+     * @param limit  The max number of subgraphs to find.
+     * @param delta  The max time duration allowed between edge matches.
+     * @return  The number of matching subgraphs (up to limit).
+     */
+    long findOrderedSubgraphs(const Graph &g, const Graph &h, const MatchCriteria &criteria, int limit = INT_MAX, int delta = INT_MAX);
+
+    /**
+     * Performs the same search, but gives each matching subgraph to a sink
+     * as soon as it's found (see GraphSearch::findOrderedSubgraphs).
+     * @param sink  Receives the edges in g matched to each edge of h (in the
+     * order of h's edges), and returns false to stop the search.
+     * @return  The number of subgraphs given to the sink.
+     */
+    long findOrderedSubgraphs(const Graph &g, const Graph &h, const MatchCriteria &criteria, const MatchSink &sink, int limit = INT_MAX, int delta = INT_MAX);
+
+    /**
+     * Counts the matching subgraphs for several delta values, with a single
+     * search using the largest one (see GraphSearch::countOrderedSubgraphs).
+     * @return  The number of matching subgraphs within each delta.
+     */
+    std::vector<long> countOrderedSubgraphs(const Graph &g, const Graph &h, const MatchCriteria &criteria, const std::vector<time_t> &deltas);
+
+    /**
+     * Sets how many threads the search uses.  With more than one, the
+     * graphs must be frozen, since they're searched from every thread.
+     * @param numThreads  Number of threads (must be at least 1).
+     */
+    void setNumThreads(int numThreads);
+    int numThreads() const { return _numThreads; }
+
+private:
+    /** Searches for the matches, giving them to output and counting them by
+     * their time span in deltaCounts (if they aren't null) */
+    long search(const Graph &g, const Graph &h, const MatchCriteria &criteria, time_t delta, MatchOutput *output, DeltaCounts *deltaCounts);
+    /** Sizes the matching state for the current graphs */
+    void resetSearchState();
+    /** Searches on multiple threads, splitting up the candidates for the first node state */
+    long findOrderedSubgraphsParallel();
+    /** Counts the matches where the first node state is matched to g_u */
+    long searchFrom(int g_u);
+    /** Counts the matches of the rest of the edge states, starting with si */
+    long search(int si);
+    /** Counts the matches with edge state si matched to g_e (and its new node to g_new, if any) */
+    long tryCandidate(int si, int g_e, int g_new);
+    /** Gives the current solution to the output.  Returns false if the search should stop. */
+    bool reportMatch();
+
+    const Graph *_g, *_h;
+    const MatchCriteria *_criteria;
+    time_t _delta;
+    int _numThreads = 1;
+    const MatchingMachine *_mama = nullptr;
+    // Candidates in G for each query node
+    NodeDomains _domains;
+    // Node in G matched to each node state, and edge in G matched to each edge state
+    std::vector<int> _solutionNodes, _solutionEdges;
+    // Earliest and latest time of the edges matched up to each edge state
+    std::vector<time_t> _minTimes, _maxTimes;
+    // Whether each node in G is matched
+    std::vector<bool> _matched;
+    // Where to give the matches (null if just counting them), and the edges
+    // of the match being given, in query edge order
+    MatchOutput *_output = nullptr;
+    std::vector<int> _matchEdges;
+    // Where to count the matches by their time span (null if not needed)
+    DeltaCounts *_deltaCounts = nullptr;
+};
+
+#endif	/* TEMPORALRISEARCH_H */
+
@@ -0,0 +1,180 @@
+/*
+ * File:   WorkStealingPool.h
+ * Author: D3M430
+ *
+ * Created on March 22, 2021, 9:40 AM
+ */
+
+#ifndef WORKSTEALINGPOOL_H
+#define	WORKSTEALINGPOOL_H
+
+#include <atomic>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Runs tasks on a fixed number of worker threads.  Each worker has its own
+ * queue of tasks, which it takes from the front of.  Once a worker's queue
+ * is empty, it steals from the back of another worker's queue, so the work
+ * stays balanced even when some tasks take much longer than others.  Tasks
+ * can also be added while running (say, by splitting up a large task).
+ */
+template<typename Task>
+class WorkStealingPool
+{
+public:
+    /** Creates a pool with the given number of workers (and queues) */
+    WorkStealingPool(int numWorkers);
+    int numWorkers() const { return _queues.size(); }
+    /** Adds a task to the end of the given worker's queue */
+    void push(int worker, const Task &task);
+    /**
+     * Gets the next task for the worker, stealing one from another worker if
+     * its own queue is empty.  Waits if there's nothing to steal, but other
+     * tasks are still running (since they may add more).  Every task that's
+     * popped must be marked as finished with finish().
+     * @return  False once all tasks are finished (or the pool was aborted).
+     */
+    bool pop(int worker, Task &task);
+    /** Number of tasks waiting in the given worker's queue */
+    int size(int worker) const;
+    /** Marks a task returned by pop() as finished */
+    void finish() { _numPending--; }
+    /** True if any worker is waiting for a task */
+    bool hungry() const { return _numWaiting.load(std::memory_order_relaxed) > 0; }
+    /** Makes pop() return false for every worker, so they stop as soon as possible */
+    void abort() { _aborted = true; }
+    /**
+     * Calls work(worker) on a separate thread for each worker, and waits for
+     * all of them to return.  If any of them throws an exception, the pool is
+     * aborted, and the first exception is thrown again once they've all stopped.
+     */
+    template<typename Work>
+    void run(Work work);
+
+private:
+    struct Queue
+    {
+        mutable std::mutex mutex;
+        std::deque<Task> tasks;
+    };
+    /** Takes a task from the front of our own queue, or the back of someone else's */
+    bool tryPop(int worker, Task &task);
+
+    std::vector<std::unique_ptr<Queue>> _queues;
+    // Tasks that have been pushed, but not finished
+    std::atomic<long> _numPending;
+    // Workers that are out of tasks
+    std::atomic<int> _numWaiting;
+    std::atomic<bool> _aborted;
+};
+
+template<typename Task>
+WorkStealingPool<Task>::WorkStealingPool(int numWorkers) : _numPending(0), _numWaiting(0), _aborted(false)
+{
+    if(numWorkers < 1)
+        throw "A work stealing pool needs at least one worker.";
+    for(int i=0; i<numWorkers; i++)
+        _queues.emplace_back(new Queue());
+}
+
+template<typename Task>
+void WorkStealingPool<Task>::push(int worker, const Task &task)
+{
+    _numPending++;
+    Queue &queue = *_queues[worker];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.tasks.push_back(task);
+}
+
+template<typename Task>
+int WorkStealingPool<Task>::size(int worker) const
+{
+    const Queue &queue = *_queues[worker];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    return queue.tasks.size();
+}
+
+template<typename Task>
+bool WorkStealingPool<Task>::tryPop(int worker, Task &task)
+{
+    int n = _queues.size();
+    for(int i=0; i<n; i++)
+    {
+        int victim = (worker + i) % n;
+        Queue &queue = *_queues[victim];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if(queue.tasks.empty())
+            continue;
+        if(victim == worker)
+        {
+            task = queue.tasks.front();
+            queue.tasks.pop_front();
+        }
+        else
+        {
+            task = queue.tasks.back();
+            queue.tasks.pop_back();
+        }
+        return true;
+    }
+    return false;
+}
+
+template<typename Task>
+bool WorkStealingPool<Task>::pop(int worker, Task &task)
+{
+    if(_aborted)
+        return false;
+    if(tryPop(worker, task))
+        return true;
+    _numWaiting++;
+    while(!_aborted && _numPending > 0)
+    {
+        if(tryPop(worker, task))
+        {
+            _numWaiting--;
+            return true;
+        }
+        std::this_thread::yield();
+    }
+    _numWaiting--;
+    return false;
+}
+
+template<typename Task>
+template<typename Work>
+void WorkStealingPool<Task>::run(Work work)
+{
+    std::exception_ptr error;
+    std::mutex errorMutex;
+    std::vector<std::thread> threads;
+    for(int worker=0; worker<numWorkers(); worker++)
+    {
+        threads.emplace_back([&, worker]()
+        {
+            try
+            {
+                work(worker);
+            }
+            catch(...)
+            {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if(!error)
+                    error = std::current_exception();
+                abort();
+            }
+        });
+    }
+    for(std::thread &thread : threads)
+        thread.join();
+    if(error)
+        std::rethrow_exception(error);
+}
+
+#endif	/* WORKSTEALINGPOOL_H */
+
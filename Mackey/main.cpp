@@ -1,4 +1,5 @@
 #include <time.h>
+#include <cmath>
 #include <iostream>
 #include "CmdArgs.h"
 #include "DataGraph.h"
@@ -6,6 +7,8 @@
 #include "GraphFilter.h"
 #include "GraphSearch.h"
 #include "MatchCriteria_DataGraph.h"
+#include "MotifCensus.h"
+#include "MultiQuerySearch.h"
 
 using namespace std;
 
@@ -24,23 +27,64 @@ int main(int argc, char **argv)
 
     cout << endl;
     cout << "-----------------------------------------------" << endl;
-	cout << "Loading data graph from " << args.graphFname() << endl;
-	DataGraph g = FileIO::loadGenericGDF(args.graphFname());
+	DataGraph g;
+	if(!args.snapshotFname().empty())
+	{
+	    cout << "Loading data graph snapshot from " << args.snapshotFname() << endl;
+	    g = FileIO::loadSnapshot(args.snapshotFname());
+	}
+	else
+	{
+	    cout << "Loading data graph from " << args.graphFname() << endl;
+	    g = FileIO::loadGenericGDF(args.graphFname());
+	}
+	if(!args.saveSnapshotFname().empty())
+	{
+	    cout << "Saving data graph snapshot to " << args.saveSnapshotFname() << endl;
+	    FileIO::saveSnapshot(g, args.saveSnapshotFname());
+	}
+	// Build all the indexes up front, so the graph is read-only while searching
+	g.freeze();
     //cout << g.nodes().size() << " nodes, " << g.edges().size() << " edges" << endl;
 	//if(g.numEdges() < MAX_NUM_EDGES_FOR_DISP)
 	    //g.disp();
 	//cout << endl;
 
+        // Count every 3 edge motif, rather than searching for queries
+        if(args.census())
+        {
+            vector<vector<long>> motifDeltaCounts;
+            for(time_t delta : args.deltaValues())
+            {
+                cout << "Counting 3 edge motifs with delta = " << delta << endl;
+                motifDeltaCounts.push_back(MotifCensus(g, delta).counts());
+            }
+            cout << "Done!" << endl;
+            clock_t tEnd = clock();
+            printf("Time elapsed: %.3f secs\n", (double)(tEnd - tStart)/CLOCKS_PER_SEC);
+
+            cout << "Query,Delta,Count" << endl;
+            for(int mi=0; mi<MotifCensus::NUM_MOTIFS; mi++)
+            {
+                for(int di=0; di<args.deltaValues().size(); di++)
+                    cout << MotifCensus::name(mi) << "," << args.deltaValues()[di] << "," << motifDeltaCounts[di][mi] << endl;
+            }
+            return 0;
+        }
+
         // Keeps track of the subgraph counts for each query and each delta value
         vector<vector<int>> queryDeltaCounts;
         
-        // Try each of the requested query graphs
+        // Load all the query graphs first, so they can be searched together
+        vector<DataGraph> queries;
+        vector<bool> possible;
         for(int i=0; i<args.queryFnames().size(); i++)
         {
             const string &queryFname = args.queryFnames()[i];
             
             cout << "Loading query graph from " << queryFname << endl;
-            DataGraph h = FileIO::loadGenericGDF(queryFname);
+            queries.push_back(FileIO::loadGenericGDF(queryFname));
+            DataGraph &h = queries.back();
             //cout << h.nodes().size() << " nodes, " << h.edges().size() << " edges" << endl;
             //if(h.numEdges() < MAX_NUM_EDGES_FOR_DISP)
                 //h.disp();
@@ -51,12 +95,69 @@ int main(int argc, char **argv)
             if(h.edgeAttributesDef() != h.edgeAttributesDef())
                 throw "Edge attribute definitions don't match between the query graph and data graph.";
 
+            // Compare strings by their IDs in the data graph.  If the query
+            // uses a string the data graph doesn't have, there's nothing to find.
+            possible.push_back(h.useDictionaries(g));
+        }
+        for(DataGraph &h : queries)
+            h.freeze();
+        
+        // Queries that start with the same edges share the search for them,
+        // so search for all of them at once (if we want every match)
+        bool batch = queries.size() > 1 && args.limit() == INT_MAX && args.algorithm() == GraphSearch::TIME_ORDER && !args.estimate();
+        if(batch)
+        {
+            cout << "Searching for all the query graphs at once in larger data graph" << endl;
+            vector<const Graph*> batchQueries;
+            for(int i=0; i<queries.size(); i++)
+            {
+                if(possible[i])
+                    batchQueries.push_back(&queries[i]);
+            }
+            MatchCriteria_DataGraph criteria;
+            MultiQuerySearch search;
+            search.setNumThreads(args.numThreads());
+            vector<vector<long>> counts = search.countOrderedSubgraphs(g, batchQueries, criteria, args.deltaValues());
+            cout << queries.size() << " query graphs were searched as " << search.numSteps() << " distinct edge steps." << endl;
+            
+            int bi = 0;
+            for(int i=0; i<queries.size(); i++)
+            {
+                cout << "Query graph " << args.queryFnames()[i] << ":" << endl;
+                vector<int> deltaCounts(args.deltaValues().size(), 0);
+                if(!possible[i])
+                    cout << "Query graph uses attribute values not found in the data graph." << endl;
+                else
+                {
+                    deltaCounts.assign(counts[bi].begin(), counts[bi].end());
+                    bi++;
+                }
+                for(int di=0; di<deltaCounts.size(); di++)
+                    cout << deltaCounts[di] << " matching subgraphs were found with delta = " << args.deltaValues()[di] << "." << endl;
+                queryDeltaCounts.push_back(deltaCounts);
+            }
+        }
+        
+        // Otherwise, try each of the requested query graphs
+        for(int i=0; i<queries.size() && !batch; i++)
+        {
+            const DataGraph &h = queries[i];
+            if(!possible[i])
+            {
+                cout << "Query graph uses attribute values not found in the data graph." << endl;
+                cout << "0 matching subgraphs were found." << endl;
+                queryDeltaCounts.push_back(vector<int>(args.deltaValues().size(), 0));
+                continue;
+            }
+
             MatchCriteria_DataGraph criteria;
             //cout << "Filtering data graph to improve query performance." << endl;
             DataGraph g2;
             g2.setNodeAttributesDef(g.nodeAttributesDef());
             g2.setEdgeAttributesDef(g.edgeAttributesDef());
-            GraphFilter::filter(g, h, criteria, g2);
+            EdgeMasks masks;
+            GraphFilter::filter(g, h, criteria, g2, masks);
+            g2.freeze();
             //cout << g2.nodes().size() << " nodes, " << g2.edges().size() << " edges" << endl;
             //if(g2.numEdges() < MAX_NUM_EDGES_FOR_DISP)
                 //g2.disp();
@@ -64,35 +165,77 @@ int main(int argc, char **argv)
             
             // Try each of the requested delta time restrictions
             vector<int> deltaCounts; // Stores number of subgraph counts for each delta value
-            for(time_t delta : args.deltaValues())
-            {                                
-                //cout << "Using delta value = " << delta << endl;
-
-                cout << "Searching for query graph in larger data graph" << endl;
-                int limit = INT_MAX; // No limit
+            int limit = args.limit();
+            if(args.estimate())
+            {
+                // Estimate the count for each delta value from a sample of the starting edges
+                for(time_t delta : args.deltaValues())
+                {
+                    cout << "Estimating matches of query graph in larger data graph" << endl;
+                    GraphSearch search;
+                    search.setNumThreads(args.numThreads());
+                    search.setEdgeMasks(&masks);
+                    CountEstimate estimate = search.estimateOrderedSubgraphs(g2, h, criteria, delta, args.maxSamples(), args.targetError());
+                    long numOccs = std::llround(estimate.count());
+                    if(estimate.exact())
+                        cout << numOccs << " matching subgraphs were found (every starting edge was sampled)." << endl;
+                    else
+                    {
+                        cout << "About " << numOccs << " +/- " << std::ceil(estimate.margin()) << " matching subgraphs were found";
+                        cout << " (95% confidence, from " << estimate.numSamples() << " of " << estimate.numRoots() << " starting edges)." << endl;
+                    }
+                    deltaCounts.push_back(numOccs);
+                }
+            }
+            else if(args.deltaValues().size() > 1 && limit == INT_MAX)
+            {
+                // Count the matches for every delta value with one search
+                cout << "Searching for query graph in larger data graph (for all delta values at once)" << endl;
                 GraphSearch search;
-                //cout << "prova" << endl;
-                //vector<GraphMatch> results = search.findOrderedSubgraphs(g2, h, criteria, limit, delta);
-                long numOccs = search.findOrderedSubgraphs(g2, h, criteria, limit, delta);
-                //cout << results.size() << " matching subgraphs were found." << endl;
-                cout << numOccs << " matching subgraphs were found." << endl;
-                //deltaCounts.push_back(results.size());
-                deltaCounts.push_back(numOccs);
+                search.setNumThreads(args.numThreads());
+                search.setAlgorithm(args.algorithm());
+                search.setEdgeMasks(&masks);
+                vector<long> counts = search.countOrderedSubgraphs(g2, h, criteria, args.deltaValues());
+                for(int di=0; di<counts.size(); di++)
+                {
+                    cout << counts[di] << " matching subgraphs were found with delta = " << args.deltaValues()[di] << "." << endl;
+                    deltaCounts.push_back(counts[di]);
+                }
+            }
+            else
+            {
+                for(time_t delta : args.deltaValues())
+                {                                
+                    //cout << "Using delta value = " << delta << endl;
 
-                //for (int j = 0; j < results.size(); j++) 
-                    //results[j].disp(); 
+                    cout << "Searching for query graph in larger data graph" << endl;
+                    GraphSearch search;
+                    search.setNumThreads(args.numThreads());
+                    search.setAlgorithm(args.algorithm());
+                    search.setEdgeMasks(&masks);
+                    //cout << "prova" << endl;
+                    //vector<GraphMatch> results = search.findOrderedSubgraphs(g2, h, criteria, limit, delta);
+                    long numOccs = search.findOrderedSubgraphs(g2, h, criteria, limit, delta);
+                    //cout << results.size() << " matching subgraphs were found." << endl;
+                    cout << numOccs << " matching subgraphs were found." << endl;
+                    //deltaCounts.push_back(results.size());
+                    deltaCounts.push_back(numOccs);
+
+                    //for (int j = 0; j < results.size(); j++) 
+                        //results[j].disp(); 
                 
-                /*cout << "Creating combo graph of all matching subgraphs" << endl;
-                            DataGraph combo = g2.createSubGraph(results);
-                            if(combo.numEdges() < MAX_NUM_EDGES_FOR_DISP)
-                                combo.disp();
-                            cout << endl;
+                    /*cout << "Creating combo graph of all matching subgraphs" << endl;
+                                DataGraph combo = g2.createSubGraph(results);
+                                if(combo.numEdges() < MAX_NUM_EDGES_FOR_DISP)
+                                    combo.disp();
+                                cout << endl;
                 
-                            string outFname = args.outFname();
-                            if(outFname.empty())
-                                outFname = args.createOutFname(args.graphFname(), queryFname, delta);
-                            cout << "Saving results to " << outFname << endl;
-                            FileIO::saveGenericGDF(combo, outFname);*/
+                                string outFname = args.outFname();
+                                if(outFname.empty())
+                                    outFname = args.createOutFname(args.graphFname(), queryFname, delta);
+                                cout << "Saving results to " << outFname << endl;
+                                FileIO::saveGenericGDF(combo, outFname);*/
+                }
             }
             queryDeltaCounts.push_back(deltaCounts);
         }        